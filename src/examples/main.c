@@ -9,12 +9,14 @@
 
 clog_config g_clog;
 
-static int checkSdlEvent(void)
+static int checkSdlEvent(int waitMs)
 {
     SDL_Event event;
     int quit = 0;
 
-    if (SDL_PollEvent(&event)) {
+    // When the previous frame was idle, sleep until input arrives instead of spinning
+    int hasEvent = waitMs > 0 ? SDL_WaitEventTimeout(&event, waitMs) : SDL_PollEvent(&event);
+    if (hasEvent) {
 
         switch (event.type) {
             case SDL_QUIT:
@@ -50,6 +52,8 @@ int main(int argc, char* argv[])
     srWindowInit(&window, 640, 360, "nimble ball presentation example");
 
     nlRenderInit(&render, window.renderer);
+    nlRenderTelemetryInit(&render, NLR_TELEMETRY_DEFAULT_NAME);
+    render.isSkippingIdleFrames = true;
 
     NlGame authoritative;
     NlGame predicted;
@@ -63,8 +67,13 @@ int main(int argc, char* argv[])
     while (1) {
         predicted.ball.circle.center.x = (float)i++;
         predicted.ball.circle.center.y = 20;
-        nlRenderUpdate(&render, &authoritative, &predicted, 0, 0, stats);
-        int wantsToQuit = checkSdlEvent();
+        stats.predictedTickId++;
+        stats.authoritativeTickId++;
+        bool wasDrawn = nlRenderUpdate(&render, &authoritative, &predicted, 0, 0, stats);
+        if (wasDrawn) {
+            SDL_RenderPresent(window.renderer);
+        }
+        int wantsToQuit = checkSdlEvent(wasDrawn ? 0 : 16);
         if (wantsToQuit) {
             break;
         }
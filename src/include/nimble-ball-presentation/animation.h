@@ -0,0 +1,65 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_ANIMATION_H
+#define NIMBLE_BALL_RENDER_SDL_ANIMATION_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NLR_MAX_ANIMATION_CLIPS (16)
+#define NLR_MAX_ANIMATION_FRAMES (16)
+#define NLR_MAX_ANIMATION_INSTANCES (96)
+#define NLR_ANIMATION_CLIP_NAME_SIZE (32)
+
+typedef enum NlrEasing {
+    NlrEasingLinear,
+    NlrEasingEaseIn,
+    NlrEasingEaseOut,
+    NlrEasingEaseInOut,
+} NlrEasing;
+
+typedef struct NlrAnimationClip {
+    char name[NLR_ANIMATION_CLIP_NAME_SIZE];
+    uint32_t durationInTicks;
+    bool isLooping;
+    NlrEasing easing;
+    float scaleFrom;
+    float scaleTo;
+    float alphaFrom;
+    float alphaTo;
+    SDL_Rect frames[NLR_MAX_ANIMATION_FRAMES];
+    size_t frameCount;
+} NlrAnimationClip;
+
+/// Output fields (frameIndex, scale, alpha and isDone) are written by nlrAnimationsEvaluate()
+typedef struct NlrAnimationInstance {
+    bool isUsed;
+    size_t clipIndex;
+    uint32_t startTickId;
+    size_t frameIndex;
+    float scale;
+    Uint8 alpha;
+    bool isDone;
+} NlrAnimationInstance;
+
+typedef struct NlrAnimations {
+    NlrAnimationClip clips[NLR_MAX_ANIMATION_CLIPS];
+    size_t clipCount;
+    NlrAnimationInstance instances[NLR_MAX_ANIMATION_INSTANCES];
+} NlrAnimations;
+
+void nlrAnimationsInit(NlrAnimations* self);
+int nlrAnimationsLoad(NlrAnimations* self, const char* filename);
+int nlrAnimationsFindClip(const NlrAnimations* self, const char* name);
+int nlrAnimationsStart(NlrAnimations* self, int clipIndex, uint32_t startTickId);
+void nlrAnimationsStop(NlrAnimations* self, int* instanceIndex);
+void nlrAnimationsEvaluate(NlrAnimations* self, uint32_t tickId);
+bool nlrAnimationsHasActive(const NlrAnimations* self);
+const NlrAnimationInstance* nlrAnimationsInstance(const NlrAnimations* self, int instanceIndex);
+const SDL_Rect* nlrAnimationsFrame(const NlrAnimations* self, const NlrAnimationInstance* instance);
+
+#endif
@@ -0,0 +1,51 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_CAMERA_H
+#define NIMBLE_BALL_RENDER_SDL_CAMERA_H
+
+#include <SDL2/SDL.h>
+#include <basal/vector2.h>
+#include <basal/vector2i.h>
+#include <stdbool.h>
+
+/// All rendering is done to a logical target of this size, which is then integer scaled to the output
+#define NLR_LOGICAL_WIDTH (640)
+#define NLR_LOGICAL_HEIGHT (360)
+
+typedef enum NlrCameraFollow {
+    NlrCameraFollowNone,
+    NlrCameraFollowBall,
+    NlrCameraFollowLocalAvatar,
+} NlrCameraFollow;
+
+typedef struct NlrCamera {
+    BlVector2 position;
+    float zoom;
+    NlrCameraFollow follow;
+    float followLerpFactor;
+    BlVector2 boundsMin;
+    BlVector2 boundsMax;
+} NlrCamera;
+
+typedef struct NlrViewport {
+    SDL_Renderer* renderer;
+    SDL_Texture* logicalTarget;
+    SDL_Rect outputRect;
+    int integerScale;
+} NlrViewport;
+
+void nlrCameraInit(NlrCamera* self, BlVector2 boundsMin, BlVector2 boundsMax);
+void nlrCameraUpdate(NlrCamera* self, BlVector2 followTarget);
+BlVector2i nlrCameraWorldToLogical(const NlrCamera* self, BlVector2 worldPosition);
+bool nlrCameraIsCircleVisible(const NlrCamera* self, BlVector2 center, float radius);
+bool nlrCameraIsRectVisible(const NlrCamera* self, BlVector2 position, BlVector2 size);
+bool nlrCameraIsSegmentVisible(const NlrCamera* self, BlVector2 a, BlVector2 b);
+
+void nlrViewportInit(NlrViewport* self, SDL_Renderer* renderer);
+void nlrViewportBegin(NlrViewport* self);
+void nlrViewportPresent(NlrViewport* self);
+void nlrViewportClose(NlrViewport* self);
+
+#endif
@@ -0,0 +1,12 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_CLOCK_H
+#define NIMBLE_BALL_RENDER_SDL_CLOCK_H
+
+#include <SDL2/SDL.h>
+
+float nlrMillisecondsBetween(Uint64 beforeCounter, Uint64 afterCounter);
+
+#endif
@@ -0,0 +1,23 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_DIVERGENCE_H
+#define NIMBLE_BALL_RENDER_SDL_DIVERGENCE_H
+
+#include <nimble-ball-simulation/nimble_ball_simulation.h>
+#include <stdbool.h>
+
+/// Positional error, in simulation units, between the main and the alternative game state.
+/// Avatar errors are kept squared, only the reported maximum is converted to a distance.
+typedef struct NlrDivergence {
+    float avatarSquaredError[NL_MAX_PLAYERS];
+    bool isAvatarDivergent[NL_MAX_PLAYERS];
+    float ballError;
+    float maxAvatarError;
+    size_t divergentAvatarCount;
+} NlrDivergence;
+
+void nlrDivergenceAnalyze(NlrDivergence* self, const NlGame* main, const NlGame* alternative, float threshold);
+
+#endif
@@ -0,0 +1,60 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_EFFECTS_H
+#define NIMBLE_BALL_RENDER_SDL_EFFECTS_H
+
+#include <nimble-ball-presentation/animation.h>
+#include <nimble-ball-simulation/nimble_ball_simulation.h>
+
+/// Room for a few ball impacts and a lifecycle event for every avatar and player slot
+#define NLR_MAX_EFFECTS (8 + NL_MAX_PLAYERS * 2)
+
+typedef enum NlrEffectKind {
+    NlrEffectKindBallImpact,
+    NlrEffectKindAvatarSpawned,
+    NlrEffectKindAvatarRemoved,
+    NlrEffectKindPlayerJoined,
+    NlrEffectKindPlayerLeft,
+} NlrEffectKind;
+
+/// A visual effect caused by a simulation event. `key` identifies the event: the collide counter value for ball
+/// impacts and the slot index for avatar and player lifecycle events, so the same event seen again after a rollback
+/// is not fired twice. Lifecycle events are unconfirmed until the authoritative state agrees with them.
+typedef struct NlrEffect {
+    bool isUsed;
+    NlrEffectKind kind;
+    uint8_t key;
+    uint32_t tickId;
+    bool isConfirmed;
+    BlVector2 position;
+    int animation;
+} NlrEffect;
+
+typedef struct NlrEffectClips {
+    int ballImpact;
+    int avatarSpawned;
+    int playerJoined;
+    int playerLeft;
+} NlrEffectClips;
+
+typedef struct NlrEffects {
+    NlrEffect effects[NLR_MAX_EFFECTS];
+    NlrEffectClips clips;
+    bool hasObservedBall;
+    uint8_t observedBallCollideCounter;
+    bool hasObservedEntities;
+    bool isAvatarPresent[NL_MAX_PLAYERS];
+    bool isPlayerPresent[NL_MAX_PLAYERS];
+} NlrEffects;
+
+void nlrEffectsInit(NlrEffects* self, NlrEffectClips clips);
+void nlrEffectsObserveBall(NlrEffects* self, NlrAnimations* animations, const NlBall* ball, uint32_t tickId);
+void nlrEffectsObserveEntities(NlrEffects* self, NlrAnimations* animations, const NlGame* game, uint32_t tickId,
+                               const NlGame* authoritative, uint32_t authoritativeTickId);
+const NlrEffect* nlrEffectsFind(const NlrEffects* self, NlrEffectKind kind, uint8_t key);
+void nlrEffectsClear(NlrEffects* self, NlrAnimations* animations);
+void nlrEffectsRemoveFinished(NlrEffects* self, NlrAnimations* animations);
+
+#endif
@@ -0,0 +1,55 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_FONT_ATLAS_H
+#define NIMBLE_BALL_RENDER_SDL_FONT_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+
+#define NLR_FONT_ATLAS_FIRST_GLYPH (32)
+#define NLR_FONT_ATLAS_GLYPH_COUNT (95)
+#define NLR_FONT_ATLAS_MAX_QUADS (512)
+
+typedef struct NlrGlyph {
+    SDL_Rect atlasRect;
+    int advance;
+} NlrGlyph;
+
+/// All glyphs rasterized once into a single texture. Text of any size is drawn as scaled quads from it, so the
+/// rasterized size should be the smallest size that is drawn; sampling is linear without mip levels.
+typedef struct NlrFontAtlas {
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    int textureWidth;
+    int textureHeight;
+    int rasterizedSize;
+    NlrGlyph glyphs[NLR_FONT_ATLAS_GLYPH_COUNT];
+    int indices[NLR_FONT_ATLAS_MAX_QUADS * 6];
+} NlrFontAtlas;
+
+/// Glyph quads that are submitted with a single draw call. Can be kept and rendered again without rebuilding.
+typedef struct NlrTextBatch {
+    SDL_Vertex vertices[NLR_FONT_ATLAS_MAX_QUADS * 4];
+    size_t quadCount;
+} NlrTextBatch;
+
+typedef struct NlrFont {
+    const NlrFontAtlas* atlas;
+    NlrTextBatch* batch;
+    float size;
+} NlrFont;
+
+int nlrFontAtlasInit(NlrFontAtlas* self, SDL_Renderer* renderer, const char* ttfFilename, int rasterizedSize);
+void nlrFontAtlasDrawText(const NlrFontAtlas* self, NlrTextBatch* batch, const char* text, int x, int y, float size,
+                          SDL_Color color);
+void nlrFontAtlasRender(const NlrFontAtlas* self, const NlrTextBatch* batch);
+void nlrFontAtlasClose(NlrFontAtlas* self);
+
+void nlrTextBatchClear(NlrTextBatch* self);
+
+void nlrFontInit(NlrFont* self, const NlrFontAtlas* atlas, NlrTextBatch* batch, float size);
+void nlrFontDrawText(const NlrFont* self, const char* text, int x, int y, SDL_Color color);
+
+#endif
@@ -0,0 +1,38 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_PLAYOUT_H
+#define NIMBLE_BALL_RENDER_SDL_PLAYOUT_H
+
+#include <SDL2/SDL.h>
+#include <nimble-ball-simulation/nimble_ball_simulation.h>
+
+#define NLR_PLAYOUT_CAPACITY (8)
+
+typedef struct NlrPlayoutSnapshot {
+    uint32_t tickId;
+    NlGame game;
+} NlrPlayoutSnapshot;
+
+/// Buffers authoritative game states and plays them back with an adaptive delay, interpolating between ticks.
+typedef struct NlrPlayout {
+    NlrPlayoutSnapshot snapshots[NLR_PLAYOUT_CAPACITY];
+    size_t firstIndex;
+    size_t count;
+    float tickDurationMs;
+    float jitterMs;
+    float targetDelayTicks;
+    double playoutTickId;
+    Uint64 lastArrivalCounter;
+    Uint64 lastUpdateCounter;
+    bool isExtrapolating;
+    NlGame output;
+} NlrPlayout;
+
+void nlrPlayoutInit(NlrPlayout* self, float tickDurationMs);
+void nlrPlayoutFeed(NlrPlayout* self, const NlGame* authoritative, uint32_t tickId);
+const NlGame* nlrPlayoutUpdate(NlrPlayout* self);
+double nlrPlayoutDelayTicks(const NlrPlayout* self);
+
+#endif
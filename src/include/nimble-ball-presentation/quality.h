@@ -0,0 +1,30 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_QUALITY_H
+#define NIMBLE_BALL_RENDER_SDL_QUALITY_H
+
+/// Each tier also includes the reductions of the tiers above it
+typedef enum NlrQualityTier {
+    NlrQualityTierFull,
+    NlrQualityTierNoShadows,
+    NlrQualityTierNoEffects,
+    NlrQualityTierReducedHud,
+} NlrQualityTier;
+
+/// Driven by the measured render work of each drawn frame, not the interval between frames, since that includes
+/// vsync waits and the caller's own work and never drops below the display refresh period
+typedef struct NlrQualityGovernor {
+    NlrQualityTier tier;
+    float workBudgetMs;
+    float averageWorkMs;
+    int overBudgetFrameCount;
+    int underBudgetFrameCount;
+} NlrQualityGovernor;
+
+void nlrQualityGovernorInit(NlrQualityGovernor* self, float workBudgetMs);
+void nlrQualityGovernorSetBudget(NlrQualityGovernor* self, float workBudgetMs);
+NlrQualityTier nlrQualityGovernorUpdate(NlrQualityGovernor* self, float workMs);
+
+#endif
@@ -6,8 +6,15 @@
 #define NIMBLE_BALL_RENDER_SDL_RENDER_H
 
 #include <basal/vector2i.h>
+#include <nimble-ball-presentation/animation.h>
+#include <nimble-ball-presentation/camera.h>
+#include <nimble-ball-presentation/divergence.h>
+#include <nimble-ball-presentation/effects.h>
+#include <nimble-ball-presentation/font_atlas.h>
+#include <nimble-ball-presentation/playout.h>
+#include <nimble-ball-presentation/quality.h>
+#include <nimble-ball-presentation/telemetry.h>
 #include <nimble-ball-simulation/nimble_ball_simulation.h>
-#include <sdl-render/font.h>
 #include <sdl-render/gamepad.h>
 #include <sdl-render/rect.h>
 #include <sdl-render/sprite.h>
@@ -19,10 +26,25 @@ struct NlGame;
 
 typedef struct NlRenderStats {
     uint32_t predictedTickId;
+    /// Must advance with every new authoritative state unless nlRenderFeedAuthoritative() is used, since the playout
+    /// buffer is then fed from nlRenderUpdate() and ignores an authoritative state with an already seen tick id
     uint32_t authoritativeTickId;
     int authoritativeStepsInBuffer;
     int renderFps;
     int latencyMs;
+    float maxAvatarDivergence;
+    float ballDivergence;
+    int divergentAvatarCount;
+    NlrQualityTier qualityTier;
+    int playoutDelayMs;
+    /// Render work in nlRenderUpdate, the sum of the sections below
+    float frameMs;
+    float updateMs;
+    float worldMs;
+    float hudMs;
+    /// Text batches and the copy of the logical target. SDL_RenderPresent() and any vsync wait are in the caller.
+    float submitMs;
+    bool isIdle;
 } NlRenderStats;
 
 typedef enum NlRenderMode {
@@ -36,17 +58,14 @@ typedef struct NlrEntityInfo {
 
 typedef struct NlrBall {
     NlrEntityInfo info;
-    size_t spawnCountDown;
-    uint8_t simulationCollideCounter;
-    size_t lastCollisionCountDown;
-    BlVector2i lastImpactPosition;
+    int spawnAnimation;
     BlVector2 precisionPosition;
 } NlrBall;
 
 typedef struct NlrPlayer {
     NlrEntityInfo info;
-    int countDown;
-    size_t destroyCountdown;
+    uint8_t playerIndex;
+    uint8_t preferredTeamId;
 } NlrPlayer;
 
 typedef struct NlrLocalPlayer {
@@ -60,10 +79,11 @@ typedef struct NlrLocalPlayer {
 
 typedef struct NlrAvatar {
     NlrEntityInfo info;
-    size_t spawnCountDown;
     BlVector2i lastPosition;
     BlVector2 precisionPosition;
     float rotation;
+    BlVector2 leadOffset;
+    float rotationLead;
 } NlrAvatar;
 
 typedef struct NlRender {
@@ -83,19 +103,55 @@ typedef struct NlRender {
     SrSprites spriteRender;
     SrRects rectangleRender;
     SDL_Renderer* renderer;
-    SrFont font;
-    SrFont bigFont;
+    NlrFontAtlas fontAtlas;
+    NlrTextBatch textBatch;
+    NlrTextBatch hudTextBatch;
+    NlrFont font;
+    NlrFont bigFont;
+    NlrFont hudFont;
+    NlrFont hudBigFont;
     NlRenderStats stats;
     NlRenderMode mode;
+    NlrCamera camera;
+    NlrViewport viewport;
+    NlrDivergence divergence;
+    float shadowDivergenceThreshold;
+    NlrAnimations animations;
+    int ballSpawnClip;
+    uint32_t tickId;
+    NlrQualityGovernor quality;
+    uint32_t frameCount;
+    NlrPlayout playout;
+    bool isAuthoritativeFedExplicitly;
+    NlrTelemetry telemetry;
+    NlrEffects effects;
+    NlRenderMode effectsMode;
+    /// Optional, off by default. nlRenderUpdate() skips drawing when nothing visible changed, see its return value
+    bool isSkippingIdleFrames;
+    uint64_t lastSceneHash;
+    uint64_t lastHudHash;
+    uint64_t lastStatsHash;
+    Uint64 lastStatsRedrawCounter;
+    uint32_t settleFramesLeft;
+    uint32_t lastDrawnTickId;
+    /// Optional, off by default. Leads locally controlled avatars with the latest input, render only
+    bool isLocalInputExtrapolated;
+    uint32_t lastPredictedTickId;
+    Uint64 predictedTickCounter;
 } NlRender;
 
 void nlRenderInit(NlRender* self, SDL_Renderer* renderer);
 void nlRenderFeedInput(NlRender* self, SrGamepad* gamepads, const NlGame* predicted, const uint8_t localParticipants[],
                        size_t localParticipantCount);
-void nlRenderUpdate(NlRender* self, const struct NlGame* authoritative, const struct NlGame* predicted,
+/// Returns true if a frame was drawn and should be presented. Always true unless isSkippingIdleFrames is set.
+/// When false, the renderer was not touched and the caller must not clear or present, so the previous frame stays.
+bool nlRenderUpdate(NlRender* self, const struct NlGame* authoritative, const struct NlGame* predicted,
                     const uint8_t localParticipants[], size_t localParticipantCount, const NlRenderStats stats);
 
 NlrLocalPlayer* nlRenderFindLocalPlayerFromParticipantId(NlRender* self, uint8_t participantId);
+void nlRenderFeedAuthoritative(NlRender* self, const struct NlGame* authoritative, uint32_t tickId);
+void nlRenderSetWorkBudget(NlRender* self, float workBudgetMs);
+int nlRenderTelemetryInit(NlRender* self, const char* sharedMemoryName);
 void nlRenderClose(NlRender* self);
 
 #endif
@@ -0,0 +1,61 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#ifndef NIMBLE_BALL_RENDER_SDL_TELEMETRY_H
+#define NIMBLE_BALL_RENDER_SDL_TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NLR_TELEMETRY_MAGIC (0x4e4c5254u)
+#define NLR_TELEMETRY_VERSION (1u)
+#define NLR_TELEMETRY_RECORD_CAPACITY (1024u)
+#define NLR_TELEMETRY_DEFAULT_NAME "/nimble-ball-telemetry"
+
+/// Nothing changed, so the frame was neither drawn nor presented
+#define NLR_TELEMETRY_FLAG_IDLE (1u)
+
+/// Fixed layout, shared with external readers. `sequence` is odd while the record is being written,
+/// and `frameIndex * 2 + 2` when it is complete.
+typedef struct NlrTelemetryRecord {
+    uint64_t sequence;
+    uint64_t frameIndex;
+    uint32_t predictedTickId;
+    uint32_t authoritativeTickId;
+    int32_t authoritativeStepsInBuffer;
+    int32_t renderFps;
+    int32_t latencyMs;
+    int32_t qualityTier;
+    int32_t playoutDelayMs;
+    int32_t divergentAvatarCount;
+    float maxAvatarDivergence;
+    float ballDivergence;
+    float frameMs;
+    float updateMs;
+    float worldMs;
+    float hudMs;
+    float submitMs;
+    uint32_t flags;
+} NlrTelemetryRecord;
+
+/// Single producer ring. `writeIndex` is the number of records published so far.
+typedef struct NlrTelemetryRing {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    uint64_t writeIndex;
+    NlrTelemetryRecord records[NLR_TELEMETRY_RECORD_CAPACITY];
+} NlrTelemetryRing;
+
+typedef struct NlrTelemetry {
+    NlrTelemetryRing* ring;
+    uint64_t frameIndex;
+} NlrTelemetry;
+
+int nlrTelemetryInit(NlrTelemetry* self, const char* sharedMemoryName);
+void nlrTelemetryPublish(NlrTelemetry* self, const NlrTelemetryRecord* record);
+void nlrTelemetryClose(NlrTelemetry* self);
+
+#endif
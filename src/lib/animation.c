@@ -0,0 +1,271 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <clog/clog.h>
+#include <math.h>
+#include <nimble-ball-presentation/animation.h>
+#include <stdio.h>
+#include <string.h>
+
+/// Built in, so spawns, impacts and the player banners work even without a data file. Loaded clips with the same name
+/// replace these.
+static const NlrAnimationClip defaultClips[] = {
+    {"avatar_spawn", 60u, false, NlrEasingLinear, 0.0f, 1.0f, 255.0f, 255.0f, {{0, 0, 0, 0}}, 0u},
+    {"ball_spawn", 60u, false, NlrEasingLinear, 0.0f, 1.0f, 255.0f, 255.0f, {{0, 0, 0, 0}}, 0u},
+    {"ball_impact", 12u, false, NlrEasingLinear, 1.0f, 1.0f, 255.0f, 255.0f,
+     {{32, 0, 16, 16}, {48, 0, 16, 16}, {64, 0, 16, 16}}, 3u},
+    {"player_joined", 180u, false, NlrEasingLinear, 1.0f, 1.0f, 255.0f, 255.0f, {{0, 0, 0, 0}}, 0u},
+    {"player_left", 120u, false, NlrEasingLinear, 1.0f, 1.0f, 255.0f, 255.0f, {{0, 0, 0, 0}}, 0u},
+};
+
+void nlrAnimationsInit(NlrAnimations* self)
+{
+    self->clipCount = sizeof(defaultClips) / sizeof(defaultClips[0]);
+    for (size_t i = 0u; i < self->clipCount; ++i) {
+        self->clips[i] = defaultClips[i];
+    }
+
+    for (size_t i = 0u; i < NLR_MAX_ANIMATION_INSTANCES; ++i) {
+        self->instances[i].isUsed = false;
+    }
+}
+
+static int parseEasing(const char* name, NlrEasing* easing)
+{
+    if (strcmp(name, "linear") == 0) {
+        *easing = NlrEasingLinear;
+    } else if (strcmp(name, "easeIn") == 0) {
+        *easing = NlrEasingEaseIn;
+    } else if (strcmp(name, "easeOut") == 0) {
+        *easing = NlrEasingEaseOut;
+    } else if (strcmp(name, "easeInOut") == 0) {
+        *easing = NlrEasingEaseInOut;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+/// Returns the index of the parsed clip, which replaces an existing clip with the same name
+static int parseClipLine(NlrAnimations* self, const char* line)
+{
+    NlrAnimationClip clip;
+    char playMode[16];
+    char easingName[16];
+    unsigned int durationInTicks;
+
+    int parsedCount = sscanf(line, "clip %31s %u %15s %15s %f %f %f %f", clip.name, &durationInTicks, playMode,
+                             easingName, &clip.scaleFrom, &clip.scaleTo, &clip.alphaFrom, &clip.alphaTo);
+    if (parsedCount != 8 || durationInTicks == 0u) {
+        return -2;
+    }
+
+    if (parseEasing(easingName, &clip.easing) < 0) {
+        return -3;
+    }
+
+    clip.durationInTicks = durationInTicks;
+    clip.isLooping = strcmp(playMode, "loop") == 0;
+    clip.frameCount = 0u;
+
+    int clipIndex = nlrAnimationsFindClip(self, clip.name);
+    if (clipIndex < 0) {
+        if (self->clipCount == NLR_MAX_ANIMATION_CLIPS) {
+            return -1;
+        }
+        clipIndex = (int) self->clipCount;
+        self->clipCount++;
+    }
+    self->clips[clipIndex] = clip;
+
+    return clipIndex;
+}
+
+static int parseFrameLine(NlrAnimations* self, int clipIndex, const char* line)
+{
+    if (clipIndex < 0) {
+        return -1;
+    }
+
+    NlrAnimationClip* clip = &self->clips[clipIndex];
+    if (clip->frameCount == NLR_MAX_ANIMATION_FRAMES) {
+        return -2;
+    }
+
+    SDL_Rect* frame = &clip->frames[clip->frameCount];
+    if (sscanf(line, "frame %d %d %d %d", &frame->x, &frame->y, &frame->w, &frame->h) != 4) {
+        return -3;
+    }
+    clip->frameCount++;
+
+    return 0;
+}
+
+/// Clips are described one per line as `clip name durationInTicks once|loop easing scaleFrom scaleTo alphaFrom
+/// alphaTo`, optionally followed by `frame x y w h` lines with sprite sheet rectangles. Lines that can not be parsed
+/// are skipped, and the built in clip with that name is kept.
+int nlrAnimationsLoad(NlrAnimations* self, const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (file == 0) {
+        CLOG_WARN("could not open animations '%s', using built in clips", filename)
+        return -1;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    int clipIndex = -1;
+    int result = 0;
+    while (fgets(line, sizeof(line), file) != 0) {
+        lineNumber++;
+        int lineResult = 0;
+        if (strncmp(line, "clip ", 5) == 0) {
+            clipIndex = parseClipLine(self, line);
+            lineResult = clipIndex;
+        } else if (strncmp(line, "frame ", 6) == 0) {
+            lineResult = parseFrameLine(self, clipIndex, line);
+        }
+        if (lineResult < 0) {
+            CLOG_WARN("could not parse animations '%s' line %d", filename, lineNumber)
+            result = lineResult;
+        }
+    }
+
+    fclose(file);
+
+    return result;
+}
+
+int nlrAnimationsFindClip(const NlrAnimations* self, const char* name)
+{
+    for (size_t i = 0u; i < self->clipCount; ++i) {
+        if (strcmp(self->clips[i].name, name) == 0) {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+static float ease(NlrEasing easing, float t)
+{
+    switch (easing) {
+        case NlrEasingEaseIn:
+            return t * t;
+        case NlrEasingEaseOut:
+            return 1.0f - (1.0f - t) * (1.0f - t);
+        case NlrEasingEaseInOut:
+            return t * t * (3.0f - 2.0f * t);
+        case NlrEasingLinear:
+            break;
+    }
+
+    return t;
+}
+
+static void evaluateInstance(const NlrAnimations* self, NlrAnimationInstance* instance, uint32_t tickId)
+{
+    const NlrAnimationClip* clip = &self->clips[instance->clipIndex];
+
+    int32_t elapsedTicks = (int32_t) (tickId - instance->startTickId);
+    if (elapsedTicks < 0) {
+        elapsedTicks = 0;
+    }
+
+    float normalizedTime = (float) elapsedTicks / (float) clip->durationInTicks;
+    instance->isDone = false;
+    if (clip->isLooping) {
+        normalizedTime = fmodf(normalizedTime, 1.0f);
+    } else if (normalizedTime >= 1.0f) {
+        normalizedTime = 1.0f;
+        instance->isDone = true;
+    }
+
+    if (clip->frameCount > 0u) {
+        size_t frameIndex = (size_t) (normalizedTime * (float) clip->frameCount);
+        instance->frameIndex = frameIndex < clip->frameCount ? frameIndex : clip->frameCount - 1u;
+    } else {
+        instance->frameIndex = 0u;
+    }
+
+    float easedTime = ease(clip->easing, normalizedTime);
+    instance->scale = clip->scaleFrom + (clip->scaleTo - clip->scaleFrom) * easedTime;
+    instance->alpha = (Uint8) (clip->alphaFrom + (clip->alphaTo - clip->alphaFrom) * easedTime);
+}
+
+int nlrAnimationsStart(NlrAnimations* self, int clipIndex, uint32_t startTickId)
+{
+    if (clipIndex < 0 || (size_t) clipIndex >= self->clipCount) {
+        return -1;
+    }
+
+    for (size_t i = 0u; i < NLR_MAX_ANIMATION_INSTANCES; ++i) {
+        NlrAnimationInstance* instance = &self->instances[i];
+        if (instance->isUsed) {
+            continue;
+        }
+        instance->isUsed = true;
+        instance->clipIndex = (size_t) clipIndex;
+        instance->startTickId = startTickId;
+        evaluateInstance(self, instance, startTickId);
+        return (int) i;
+    }
+
+    CLOG_WARN("out of animation instances")
+    return -1;
+}
+
+void nlrAnimationsStop(NlrAnimations* self, int* instanceIndex)
+{
+    if (*instanceIndex < 0) {
+        return;
+    }
+    self->instances[*instanceIndex].isUsed = false;
+    *instanceIndex = -1;
+}
+
+/// Evaluates all active instances in one pass, so the render code only reads the results
+void nlrAnimationsEvaluate(NlrAnimations* self, uint32_t tickId)
+{
+    for (size_t i = 0u; i < NLR_MAX_ANIMATION_INSTANCES; ++i) {
+        NlrAnimationInstance* instance = &self->instances[i];
+        if (!instance->isUsed) {
+            continue;
+        }
+        evaluateInstance(self, instance, tickId);
+    }
+}
+
+/// True if any instance still changes with time
+bool nlrAnimationsHasActive(const NlrAnimations* self)
+{
+    for (size_t i = 0u; i < NLR_MAX_ANIMATION_INSTANCES; ++i) {
+        const NlrAnimationInstance* instance = &self->instances[i];
+        if (instance->isUsed && !instance->isDone) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const NlrAnimationInstance* nlrAnimationsInstance(const NlrAnimations* self, int instanceIndex)
+{
+    if (instanceIndex < 0) {
+        return 0;
+    }
+
+    return &self->instances[instanceIndex];
+}
+
+const SDL_Rect* nlrAnimationsFrame(const NlrAnimations* self, const NlrAnimationInstance* instance)
+{
+    const NlrAnimationClip* clip = &self->clips[instance->clipIndex];
+    if (clip->frameCount == 0u) {
+        return 0;
+    }
+
+    return &clip->frames[instance->frameIndex];
+}
@@ -0,0 +1,191 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <clog/clog.h>
+#include <math.h>
+#include <nimble-ball-presentation/camera.h>
+
+void nlrCameraInit(NlrCamera* self, BlVector2 boundsMin, BlVector2 boundsMax)
+{
+    // Centered on the logical target with no zoom, so simulation units map directly to logical pixels
+    self->position.x = NLR_LOGICAL_WIDTH / 2.0f;
+    self->position.y = NLR_LOGICAL_HEIGHT / 2.0f;
+    self->zoom = 1.0f;
+    self->follow = NlrCameraFollowNone;
+    self->followLerpFactor = 0.1f;
+    self->boundsMin = boundsMin;
+    self->boundsMax = boundsMax;
+}
+
+static float clampAxis(float value, float halfExtent, float boundsMin, float boundsMax)
+{
+    if (boundsMax - boundsMin <= halfExtent * 2.0f) {
+        return (boundsMin + boundsMax) / 2.0f;
+    }
+
+    if (value < boundsMin + halfExtent) {
+        return boundsMin + halfExtent;
+    }
+
+    if (value > boundsMax - halfExtent) {
+        return boundsMax - halfExtent;
+    }
+
+    return value;
+}
+
+void nlrCameraUpdate(NlrCamera* self, BlVector2 followTarget)
+{
+    if (self->follow == NlrCameraFollowNone) {
+        return;
+    }
+
+    self->position.x += (followTarget.x - self->position.x) * self->followLerpFactor;
+    self->position.y += (followTarget.y - self->position.y) * self->followLerpFactor;
+
+    float halfWidth = NLR_LOGICAL_WIDTH / 2.0f / self->zoom;
+    float halfHeight = NLR_LOGICAL_HEIGHT / 2.0f / self->zoom;
+
+    self->position.x = clampAxis(self->position.x, halfWidth, self->boundsMin.x, self->boundsMax.x);
+    self->position.y = clampAxis(self->position.y, halfHeight, self->boundsMin.y, self->boundsMax.y);
+}
+
+BlVector2i nlrCameraWorldToLogical(const NlrCamera* self, BlVector2 worldPosition)
+{
+    float x = (worldPosition.x - self->position.x) * self->zoom + NLR_LOGICAL_WIDTH / 2.0f;
+    float y = (worldPosition.y - self->position.y) * self->zoom + NLR_LOGICAL_HEIGHT / 2.0f;
+
+    float roundedX = floorf(x + 0.5f);
+    float roundedY = floorf(y + 0.5f);
+
+    BlVector2i result;
+    result.x = (int) roundedX;
+    result.y = (int) roundedY;
+
+    return result;
+}
+
+bool nlrCameraIsRectVisible(const NlrCamera* self, BlVector2 position, BlVector2 size)
+{
+    float halfWidth = NLR_LOGICAL_WIDTH / 2.0f / self->zoom;
+    float halfHeight = NLR_LOGICAL_HEIGHT / 2.0f / self->zoom;
+
+    float minX = fminf(position.x, position.x + size.x);
+    float maxX = fmaxf(position.x, position.x + size.x);
+    float minY = fminf(position.y, position.y + size.y);
+    float maxY = fmaxf(position.y, position.y + size.y);
+
+    return maxX >= self->position.x - halfWidth && minX <= self->position.x + halfWidth &&
+           maxY >= self->position.y - halfHeight && minY <= self->position.y + halfHeight;
+}
+
+bool nlrCameraIsCircleVisible(const NlrCamera* self, BlVector2 center, float radius)
+{
+    BlVector2 position;
+    position.x = center.x - radius;
+    position.y = center.y - radius;
+
+    BlVector2 size;
+    size.x = radius * 2.0f;
+    size.y = radius * 2.0f;
+
+    return nlrCameraIsRectVisible(self, position, size);
+}
+
+bool nlrCameraIsSegmentVisible(const NlrCamera* self, BlVector2 a, BlVector2 b)
+{
+    return nlrCameraIsRectVisible(self, a, blVector2Sub(b, a));
+}
+
+void nlrViewportInit(NlrViewport* self, SDL_Renderer* renderer)
+{
+    self->renderer = renderer;
+    self->logicalTarget = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                            NLR_LOGICAL_WIDTH, NLR_LOGICAL_HEIGHT);
+    self->integerScale = 1;
+    self->outputRect.x = 0;
+    self->outputRect.y = 0;
+    self->outputRect.w = NLR_LOGICAL_WIDTH;
+    self->outputRect.h = NLR_LOGICAL_HEIGHT;
+
+    if (self->logicalTarget == 0) {
+        // Renderers without render target support draw directly, scaled and letterboxed by SDL instead
+        CLOG_WARN("could not create logical render target, rendering directly to the output")
+        SDL_RenderSetLogicalSize(renderer, NLR_LOGICAL_WIDTH, NLR_LOGICAL_HEIGHT);
+        SDL_RenderSetIntegerScale(renderer, SDL_TRUE);
+        return;
+    }
+
+    SDL_SetTextureBlendMode(self->logicalTarget, SDL_BLENDMODE_NONE);
+}
+
+void nlrViewportBegin(NlrViewport* self)
+{
+    if (self->logicalTarget != 0) {
+        SDL_SetRenderTarget(self->renderer, self->logicalTarget);
+    }
+    SDL_SetRenderDrawColor(self->renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(self->renderer);
+}
+
+static void calculateOutputRect(NlrViewport* self, int outputWidth, int outputHeight)
+{
+    int scaleX = outputWidth / NLR_LOGICAL_WIDTH;
+    int scaleY = outputHeight / NLR_LOGICAL_HEIGHT;
+    int scale = scaleX < scaleY ? scaleX : scaleY;
+
+    if (scale >= 1) {
+        self->integerScale = scale;
+        self->outputRect.w = NLR_LOGICAL_WIDTH * scale;
+        self->outputRect.h = NLR_LOGICAL_HEIGHT * scale;
+        SDL_SetTextureScaleMode(self->logicalTarget, SDL_ScaleModeNearest);
+    } else {
+        // Output is smaller than the logical target (handhelds), fit it while keeping the aspect ratio
+        self->integerScale = 0;
+        if (outputWidth * NLR_LOGICAL_HEIGHT < outputHeight * NLR_LOGICAL_WIDTH) {
+            self->outputRect.w = outputWidth;
+            self->outputRect.h = outputWidth * NLR_LOGICAL_HEIGHT / NLR_LOGICAL_WIDTH;
+        } else {
+            self->outputRect.w = outputHeight * NLR_LOGICAL_WIDTH / NLR_LOGICAL_HEIGHT;
+            self->outputRect.h = outputHeight;
+        }
+        SDL_SetTextureScaleMode(self->logicalTarget, SDL_ScaleModeLinear);
+    }
+
+    self->outputRect.x = (outputWidth - self->outputRect.w) / 2;
+    self->outputRect.y = (outputHeight - self->outputRect.h) / 2;
+}
+
+void nlrViewportPresent(NlrViewport* self)
+{
+    if (self->logicalTarget == 0) {
+        // Everything was already drawn to the output
+        return;
+    }
+
+    SDL_SetRenderTarget(self->renderer, 0);
+
+    int outputWidth;
+    int outputHeight;
+    if (SDL_GetRendererOutputSize(self->renderer, &outputWidth, &outputHeight) < 0) {
+        outputWidth = NLR_LOGICAL_WIDTH;
+        outputHeight = NLR_LOGICAL_HEIGHT;
+    }
+
+    calculateOutputRect(self, outputWidth, outputHeight);
+
+    // The letterbox bars are not covered by the copy, clear them so they don't show stale backbuffer contents
+    SDL_SetRenderDrawColor(self->renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(self->renderer);
+    SDL_RenderCopy(self->renderer, self->logicalTarget, 0, &self->outputRect);
+}
+
+void nlrViewportClose(NlrViewport* self)
+{
+    if (self->logicalTarget == 0) {
+        return;
+    }
+    SDL_DestroyTexture(self->logicalTarget);
+    self->logicalTarget = 0;
+}
@@ -0,0 +1,12 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <nimble-ball-presentation/clock.h>
+
+/// Converts the difference between two SDL_GetPerformanceCounter() values to milliseconds
+float nlrMillisecondsBetween(Uint64 beforeCounter, Uint64 afterCounter)
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    return (float) (afterCounter - beforeCounter) * 1000.0f / (float) frequency;
+}
@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <float.h>
+#include <math.h>
+#include <nimble-ball-presentation/divergence.h>
+
+typedef struct NlrAvatarPositions {
+    float x[NL_MAX_PLAYERS];
+    float y[NL_MAX_PLAYERS];
+} NlrAvatarPositions;
+
+static void gatherAvatarPositions(NlrAvatarPositions* positions, const NlAvatars* avatars)
+{
+    for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
+        positions->x[i] = 0.0f;
+        positions->y[i] = 0.0f;
+    }
+
+    for (size_t i = 0u; i < avatars->avatarCount; ++i) {
+        positions->x[i] = avatars->avatars[i].circle.center.x;
+        positions->y[i] = avatars->avatars[i].circle.center.y;
+    }
+}
+
+/// Branch free over the whole fixed size array, so the compiler can vectorize it. Squared, since sqrtf() can set errno
+/// and would prevent vectorization unless the whole project is built with -fno-math-errno.
+static void calculateSquaredDistances(float* restrict squaredDistances, const NlrAvatarPositions* restrict a,
+                                      const NlrAvatarPositions* restrict b)
+{
+    for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
+        float deltaX = a->x[i] - b->x[i];
+        float deltaY = a->y[i] - b->y[i];
+        squaredDistances[i] = deltaX * deltaX + deltaY * deltaY;
+    }
+}
+
+void nlrDivergenceAnalyze(NlrDivergence* self, const NlGame* main, const NlGame* alternative, float threshold)
+{
+    NlrAvatarPositions mainPositions;
+    NlrAvatarPositions alternativePositions;
+
+    gatherAvatarPositions(&mainPositions, &main->avatars);
+    gatherAvatarPositions(&alternativePositions, &alternative->avatars);
+
+    calculateSquaredDistances(self->avatarSquaredError, &mainPositions, &alternativePositions);
+
+    // Avatars that only exist in the alternative state have no counterpart, they always diverge
+    for (size_t i = main->avatars.avatarCount; i < alternative->avatars.avatarCount; ++i) {
+        self->avatarSquaredError[i] = FLT_MAX;
+    }
+
+    float squaredThreshold = threshold * threshold;
+    float maxSquaredError = 0.0f;
+    self->divergentAvatarCount = 0u;
+    for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
+        float squaredError = self->avatarSquaredError[i];
+        bool isInAlternative = i < alternative->avatars.avatarCount;
+        if (squaredError > maxSquaredError && i < main->avatars.avatarCount && isInAlternative) {
+            maxSquaredError = squaredError;
+        }
+        self->isAvatarDivergent[i] = isInAlternative && squaredError >= squaredThreshold;
+        if (self->isAvatarDivergent[i]) {
+            self->divergentAvatarCount++;
+        }
+    }
+    self->maxAvatarError = sqrtf(maxSquaredError);
+
+    float ballDeltaX = main->ball.circle.center.x - alternative->ball.circle.center.x;
+    float ballDeltaY = main->ball.circle.center.y - alternative->ball.circle.center.y;
+    self->ballError = sqrtf(ballDeltaX * ballDeltaX + ballDeltaY * ballDeltaY);
+}
@@ -0,0 +1,243 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <nimble-ball-presentation/effects.h>
+
+void nlrEffectsInit(NlrEffects* self, NlrEffectClips clips)
+{
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        self->effects[i].isUsed = false;
+    }
+    self->clips = clips;
+    self->hasObservedBall = false;
+    self->observedBallCollideCounter = 0u;
+    self->hasObservedEntities = false;
+}
+
+static void removeEffect(NlrEffect* effect, NlrAnimations* animations)
+{
+    nlrAnimationsStop(animations, &effect->animation);
+    effect->isUsed = false;
+}
+
+static int findEffectIndex(const NlrEffects* self, NlrEffectKind kind, uint8_t key)
+{
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        const NlrEffect* effect = &self->effects[i];
+        if (effect->isUsed && effect->kind == kind && effect->key == key) {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+static NlrEffect* findEffect(NlrEffects* self, NlrEffectKind kind, uint8_t key)
+{
+    int index = findEffectIndex(self, kind, key);
+    return index < 0 ? 0 : &self->effects[index];
+}
+
+const NlrEffect* nlrEffectsFind(const NlrEffects* self, NlrEffectKind kind, uint8_t key)
+{
+    int index = findEffectIndex(self, kind, key);
+    return index < 0 ? 0 : &self->effects[index];
+}
+
+static NlrEffect* allocateEffect(NlrEffects* self, NlrAnimations* animations)
+{
+    NlrEffect* oldest = &self->effects[0];
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        NlrEffect* effect = &self->effects[i];
+        if (!effect->isUsed) {
+            return effect;
+        }
+        if ((int32_t) (effect->tickId - oldest->tickId) < 0) {
+            oldest = effect;
+        }
+    }
+
+    removeEffect(oldest, animations);
+    return oldest;
+}
+
+static NlrEffect* addEffect(NlrEffects* self, NlrAnimations* animations, NlrEffectKind kind, uint8_t key,
+                            uint32_t tickId, int clip)
+{
+    NlrEffect* effect = allocateEffect(self, animations);
+    effect->isUsed = true;
+    effect->kind = kind;
+    effect->key = key;
+    effect->tickId = tickId;
+    effect->isConfirmed = false;
+    effect->position.x = 0.0f;
+    effect->position.y = 0.0f;
+    effect->animation = nlrAnimationsStart(animations, clip, tickId);
+
+    return effect;
+}
+
+/// Removes effects for events that the state at `tickId` says never happened. Counters only increase in a single
+/// timeline, so an effect with a key ahead of the counter must have been mispredicted and then rolled back.
+static void removeRefutedEffects(NlrEffects* self, NlrAnimations* animations, NlrEffectKind kind, uint8_t counter,
+                                 uint32_t tickId)
+{
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        NlrEffect* effect = &self->effects[i];
+        if (!effect->isUsed || effect->kind != kind) {
+            continue;
+        }
+
+        bool isKeyAhead = (int8_t) (effect->key - counter) > 0;
+        bool isTickReached = (int32_t) (tickId - effect->tickId) >= 0;
+        if (isKeyAhead && isTickReached) {
+            removeEffect(effect, animations);
+        }
+    }
+}
+
+void nlrEffectsObserveBall(NlrEffects* self, NlrAnimations* animations, const NlBall* ball, uint32_t tickId)
+{
+    uint8_t counter = ball->collideCounter;
+
+    if (!self->hasObservedBall) {
+        self->hasObservedBall = true;
+        self->observedBallCollideCounter = counter;
+        return;
+    }
+
+    removeRefutedEffects(self, animations, NlrEffectKindBallImpact, counter, tickId);
+
+    bool isNewImpact = (int8_t) (counter - self->observedBallCollideCounter) > 0;
+    self->observedBallCollideCounter = counter;
+    // A counter that went back is a rollback, the impacts it refuted were removed above
+    if (!isNewImpact) {
+        return;
+    }
+
+    // Already recorded before a rollback and confirmed again by the resimulation, keep it playing but move it to
+    // where and when the resimulation says it happened
+    NlrEffect* replayed = findEffect(self, NlrEffectKindBallImpact, counter);
+    if (replayed != 0) {
+        replayed->tickId = tickId;
+        replayed->position = ball->circle.center;
+        return;
+    }
+
+    NlrEffect* effect = addEffect(self, animations, NlrEffectKindBallImpact, counter, tickId, self->clips.ballImpact);
+    // Impacts are refuted through their counter instead
+    effect->isConfirmed = true;
+    effect->position = ball->circle.center;
+}
+
+static bool isAppearKind(NlrEffectKind kind)
+{
+    return kind == NlrEffectKindAvatarSpawned || kind == NlrEffectKindPlayerJoined;
+}
+
+/// An event that disappears again before the authoritative state confirmed it was mispredicted and then rolled back.
+/// It is removed without firing the opposite event, so a rolled back join doesn't show a left banner.
+static void observePresence(NlrEffects* self, NlrAnimations* animations, bool* isPresentFlags, size_t presentCount,
+                            NlrEffectKind appearKind, NlrEffectKind disappearKind, int appearClip,
+                            int disappearClip, uint32_t tickId)
+{
+    for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
+        bool isPresent = i < presentCount;
+        if (isPresent == isPresentFlags[i]) {
+            continue;
+        }
+        isPresentFlags[i] = isPresent;
+
+        uint8_t key = (uint8_t) i;
+        NlrEffect* opposite = findEffect(self, isPresent ? disappearKind : appearKind, key);
+        if (opposite != 0) {
+            bool wasMispredicted = !opposite->isConfirmed;
+            removeEffect(opposite, animations);
+            if (wasMispredicted) {
+                continue;
+            }
+        }
+
+        addEffect(self, animations, isPresent ? appearKind : disappearKind, key, tickId,
+                  isPresent ? appearClip : disappearClip);
+    }
+}
+
+static void confirmEffects(NlrEffects* self, const NlGame* authoritative, uint32_t authoritativeTickId)
+{
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        NlrEffect* effect = &self->effects[i];
+        if (!effect->isUsed || effect->isConfirmed || (int32_t) (authoritativeTickId - effect->tickId) < 0) {
+            continue;
+        }
+
+        size_t authoritativeCount = 0u;
+        switch (effect->kind) {
+            case NlrEffectKindAvatarSpawned:
+            case NlrEffectKindAvatarRemoved:
+                authoritativeCount = authoritative->avatars.avatarCount;
+                break;
+            case NlrEffectKindPlayerJoined:
+            case NlrEffectKindPlayerLeft:
+                authoritativeCount = authoritative->players.playerCount;
+                break;
+            case NlrEffectKindBallImpact:
+                continue;
+        }
+
+        bool isPresentInAuthoritative = effect->key < authoritativeCount;
+        effect->isConfirmed = isPresentInAuthoritative == isAppearKind(effect->kind);
+    }
+}
+
+/// Avatar spawns, player joins and leaves are kept in the same log as the impacts, so a prediction that is rolled
+/// back doesn't leave banners or spawn animations behind, and a replayed event doesn't start over.
+void nlrEffectsObserveEntities(NlrEffects* self, NlrAnimations* animations, const NlGame* game, uint32_t tickId,
+                               const NlGame* authoritative, uint32_t authoritativeTickId)
+{
+    if (!self->hasObservedEntities) {
+        // Entities that already exist when we start observing are not announced
+        self->hasObservedEntities = true;
+        for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
+            self->isAvatarPresent[i] = i < game->avatars.avatarCount;
+            self->isPlayerPresent[i] = i < game->players.playerCount;
+        }
+        return;
+    }
+
+    observePresence(self, animations, self->isAvatarPresent, game->avatars.avatarCount, NlrEffectKindAvatarSpawned,
+                    NlrEffectKindAvatarRemoved, self->clips.avatarSpawned, -1, tickId);
+    observePresence(self, animations, self->isPlayerPresent, game->players.playerCount, NlrEffectKindPlayerJoined,
+                    NlrEffectKindPlayerLeft, self->clips.playerJoined, self->clips.playerLeft, tickId);
+
+    confirmEffects(self, authoritative, authoritativeTickId);
+}
+
+/// Forgets all effects and observations, e.g. when switching to a game state with a different timeline
+void nlrEffectsClear(NlrEffects* self, NlrAnimations* animations)
+{
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        NlrEffect* effect = &self->effects[i];
+        if (effect->isUsed) {
+            removeEffect(effect, animations);
+        }
+    }
+    self->hasObservedBall = false;
+    self->hasObservedEntities = false;
+}
+
+/// Unconfirmed events are kept after their animation is done, so they can still be refuted by a rollback
+void nlrEffectsRemoveFinished(NlrEffects* self, NlrAnimations* animations)
+{
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        NlrEffect* effect = &self->effects[i];
+        if (!effect->isUsed) {
+            continue;
+        }
+        const NlrAnimationInstance* instance = nlrAnimationsInstance(animations, effect->animation);
+        if ((instance == 0 || instance->isDone) && effect->isConfirmed) {
+            removeEffect(effect, animations);
+        }
+    }
+}
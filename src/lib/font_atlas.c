@@ -0,0 +1,209 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <SDL2_ttf/SDL_ttf.h>
+#include <clog/clog.h>
+#include <nimble-ball-presentation/camera.h>
+#include <nimble-ball-presentation/font_atlas.h>
+
+static const int atlasTextureWidth = 512;
+static const int glyphPadding = 1;
+
+static void setupIndices(NlrFontAtlas* self)
+{
+    for (int i = 0; i < NLR_FONT_ATLAS_MAX_QUADS; ++i) {
+        int* quadIndices = &self->indices[i * 6];
+        int firstVertex = i * 4;
+        quadIndices[0] = firstVertex;
+        quadIndices[1] = firstVertex + 1;
+        quadIndices[2] = firstVertex + 2;
+        quadIndices[3] = firstVertex + 2;
+        quadIndices[4] = firstVertex + 3;
+        quadIndices[5] = firstVertex;
+    }
+}
+
+int nlrFontAtlasInit(NlrFontAtlas* self, SDL_Renderer* renderer, const char* ttfFilename, int rasterizedSize)
+{
+    self->renderer = renderer;
+    self->texture = 0;
+    self->rasterizedSize = rasterizedSize;
+    setupIndices(self);
+
+    if (!TTF_WasInit() && TTF_Init() < 0) {
+        CLOG_ERROR("could not initialize ttf %s", TTF_GetError())
+        return -1;
+    }
+
+    TTF_Font* font = TTF_OpenFont(ttfFilename, rasterizedSize);
+    if (font == 0) {
+        CLOG_ERROR("could not open font '%s' %s", ttfFilename, TTF_GetError())
+        return -2;
+    }
+
+    SDL_Color white = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
+    SDL_Surface* glyphSurfaces[NLR_FONT_ATLAS_GLYPH_COUNT];
+
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+
+    for (int i = 0; i < NLR_FONT_ATLAS_GLYPH_COUNT; ++i) {
+        Uint16 character = (Uint16) (NLR_FONT_ATLAS_FIRST_GLYPH + i);
+        NlrGlyph* glyph = &self->glyphs[i];
+
+        int minX, maxX, minY, maxY, advance;
+        if (TTF_GlyphMetrics(font, character, &minX, &maxX, &minY, &maxY, &advance) < 0) {
+            advance = 0;
+        }
+        glyph->advance = advance;
+
+        SDL_Surface* glyphSurface = TTF_RenderGlyph_Blended(font, character, white);
+        glyphSurfaces[i] = glyphSurface;
+        if (glyphSurface == 0) {
+            glyph->atlasRect.x = 0;
+            glyph->atlasRect.y = 0;
+            glyph->atlasRect.w = 0;
+            glyph->atlasRect.h = 0;
+            continue;
+        }
+
+        if (x + glyphSurface->w > atlasTextureWidth) {
+            x = 0;
+            y += rowHeight + glyphPadding;
+            rowHeight = 0;
+        }
+
+        glyph->atlasRect.x = x;
+        glyph->atlasRect.y = y;
+        glyph->atlasRect.w = glyphSurface->w;
+        glyph->atlasRect.h = glyphSurface->h;
+
+        x += glyphSurface->w + glyphPadding;
+        if (glyphSurface->h > rowHeight) {
+            rowHeight = glyphSurface->h;
+        }
+    }
+
+    TTF_CloseFont(font);
+
+    self->textureWidth = atlasTextureWidth;
+    self->textureHeight = y + rowHeight;
+
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, self->textureWidth, self->textureHeight, 32,
+                                                               SDL_PIXELFORMAT_RGBA32);
+    if (atlasSurface == 0) {
+        CLOG_ERROR("could not create font atlas surface")
+        return -3;
+    }
+
+    for (int i = 0; i < NLR_FONT_ATLAS_GLYPH_COUNT; ++i) {
+        SDL_Surface* glyphSurface = glyphSurfaces[i];
+        if (glyphSurface == 0) {
+            continue;
+        }
+        SDL_Rect target = self->glyphs[i].atlasRect;
+        SDL_SetSurfaceBlendMode(glyphSurface, SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(glyphSurface, 0, atlasSurface, &target);
+        SDL_FreeSurface(glyphSurface);
+    }
+
+    self->texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+    SDL_FreeSurface(atlasSurface);
+    if (self->texture == 0) {
+        CLOG_ERROR("could not create font atlas texture")
+        return -4;
+    }
+
+    SDL_SetTextureBlendMode(self->texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(self->texture, SDL_ScaleModeLinear);
+
+    return 0;
+}
+
+static void setVertex(SDL_Vertex* vertex, float x, float y, float u, float v, SDL_Color color)
+{
+    vertex->position.x = x;
+    vertex->position.y = y;
+    vertex->tex_coord.x = u;
+    vertex->tex_coord.y = v;
+    vertex->color = color;
+}
+
+/// Uses the same convention as the rest of sdl-render, y is upwards and is the top edge of the text.
+void nlrFontAtlasDrawText(const NlrFontAtlas* self, NlrTextBatch* batch, const char* text, int x, int y, float size,
+                          SDL_Color color)
+{
+    float scale = size / (float) self->rasterizedSize;
+    float penX = (float) x;
+    float top = (float) (NLR_LOGICAL_HEIGHT - y);
+    float textureWidth = (float) self->textureWidth;
+    float textureHeight = (float) self->textureHeight;
+
+    for (const char* p = text; *p != 0; ++p) {
+        int glyphIndex = (unsigned char) *p - NLR_FONT_ATLAS_FIRST_GLYPH;
+        if (glyphIndex < 0 || glyphIndex >= NLR_FONT_ATLAS_GLYPH_COUNT) {
+            glyphIndex = '?' - NLR_FONT_ATLAS_FIRST_GLYPH;
+        }
+        const NlrGlyph* glyph = &self->glyphs[glyphIndex];
+
+        if (glyph->atlasRect.w > 0) {
+            if (batch->quadCount == NLR_FONT_ATLAS_MAX_QUADS) {
+                CLOG_WARN("text batch is full")
+                return;
+            }
+
+            const SDL_Rect* rect = &glyph->atlasRect;
+            float left = penX;
+            float right = penX + (float) rect->w * scale;
+            float bottom = top + (float) rect->h * scale;
+            float u0 = (float) rect->x / textureWidth;
+            float u1 = (float) (rect->x + rect->w) / textureWidth;
+            float v0 = (float) rect->y / textureHeight;
+            float v1 = (float) (rect->y + rect->h) / textureHeight;
+
+            SDL_Vertex* quad = &batch->vertices[batch->quadCount * 4];
+            setVertex(&quad[0], left, top, u0, v0, color);
+            setVertex(&quad[1], right, top, u1, v0, color);
+            setVertex(&quad[2], right, bottom, u1, v1, color);
+            setVertex(&quad[3], left, bottom, u0, v1, color);
+            batch->quadCount++;
+        }
+
+        penX += (float) glyph->advance * scale;
+    }
+}
+
+void nlrFontAtlasRender(const NlrFontAtlas* self, const NlrTextBatch* batch)
+{
+    if (batch->quadCount == 0u) {
+        return;
+    }
+
+    int quadCount = (int) batch->quadCount;
+    SDL_RenderGeometry(self->renderer, self->texture, batch->vertices, quadCount * 4, self->indices, quadCount * 6);
+}
+
+void nlrFontAtlasClose(NlrFontAtlas* self)
+{
+    SDL_DestroyTexture(self->texture);
+    self->texture = 0;
+}
+
+void nlrTextBatchClear(NlrTextBatch* self)
+{
+    self->quadCount = 0u;
+}
+
+void nlrFontInit(NlrFont* self, const NlrFontAtlas* atlas, NlrTextBatch* batch, float size)
+{
+    self->atlas = atlas;
+    self->batch = batch;
+    self->size = size;
+}
+
+void nlrFontDrawText(const NlrFont* self, const char* text, int x, int y, SDL_Color color)
+{
+    nlrFontAtlasDrawText(self->atlas, self->batch, text, x, y, self->size, color);
+}
@@ -0,0 +1,191 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <basal/math.h>
+#include <math.h>
+#include <nimble-ball-presentation/clock.h>
+#include <nimble-ball-presentation/playout.h>
+
+static const float minimumDelayTicks = 1.0f;
+static const float jitterDelayFactor = 2.0f;
+static const double maximumExtrapolationTicks = 3.0;
+static const double snapThresholdTicks = 4.0;
+static const double catchUpFactor = 0.05;
+
+void nlrPlayoutInit(NlrPlayout* self, float tickDurationMs)
+{
+    self->firstIndex = 0u;
+    self->count = 0u;
+    self->tickDurationMs = tickDurationMs;
+    self->jitterMs = 0.0f;
+    self->targetDelayTicks = minimumDelayTicks;
+    self->playoutTickId = 0.0;
+    self->lastArrivalCounter = 0u;
+    self->lastUpdateCounter = 0u;
+    self->isExtrapolating = false;
+}
+
+static const NlrPlayoutSnapshot* snapshotAt(const NlrPlayout* self, size_t index)
+{
+    return &self->snapshots[(self->firstIndex + index) % NLR_PLAYOUT_CAPACITY];
+}
+
+static void updateJitter(NlrPlayout* self, uint32_t tickId, uint32_t newestTickId)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (self->lastArrivalCounter != 0u) {
+        float actualMs = nlrMillisecondsBetween(self->lastArrivalCounter, now);
+        float expectedMs = (float) (tickId - newestTickId) * self->tickDurationMs;
+        float deviationMs = fabsf(actualMs - expectedMs);
+        // Same smoothing as the RTP interarrival jitter estimate
+        self->jitterMs += (deviationMs - self->jitterMs) / 16.0f;
+    }
+    self->lastArrivalCounter = now;
+
+    float maximumDelayTicks = (float) (NLR_PLAYOUT_CAPACITY - 2);
+    float delayTicks = minimumDelayTicks + jitterDelayFactor * self->jitterMs / self->tickDurationMs;
+    self->targetDelayTicks = delayTicks > maximumDelayTicks ? maximumDelayTicks : delayTicks;
+}
+
+static void flush(NlrPlayout* self)
+{
+    self->firstIndex = 0u;
+    self->count = 0u;
+    self->jitterMs = 0.0f;
+    self->targetDelayTicks = minimumDelayTicks;
+    self->lastArrivalCounter = 0u;
+    self->lastUpdateCounter = 0u;
+    self->isExtrapolating = false;
+}
+
+/// Should be called for every authoritative step as it is received, so the jitter estimate sees the real arrival
+/// times. A tick that is already buffered is ignored. If the tick id goes backwards or skips past the whole buffer,
+/// for example when a new session restarts the ticks, the buffer is flushed and restarted from that tick.
+void nlrPlayoutFeed(NlrPlayout* self, const NlGame* authoritative, uint32_t tickId)
+{
+    if (self->count > 0u) {
+        uint32_t newestTickId = snapshotAt(self, self->count - 1u)->tickId;
+        int32_t tickDelta = (int32_t) (tickId - newestTickId);
+        if (tickDelta == 0) {
+            return;
+        }
+        if (tickDelta < 0 || tickDelta > NLR_PLAYOUT_CAPACITY) {
+            flush(self);
+        }
+    }
+
+    if (self->count > 0u) {
+        updateJitter(self, tickId, snapshotAt(self, self->count - 1u)->tickId);
+    } else {
+        self->playoutTickId = (double) tickId;
+        self->lastArrivalCounter = SDL_GetPerformanceCounter();
+    }
+
+    if (self->count == NLR_PLAYOUT_CAPACITY) {
+        self->firstIndex = (self->firstIndex + 1u) % NLR_PLAYOUT_CAPACITY;
+        self->count--;
+    }
+
+    NlrPlayoutSnapshot* snapshot = &self->snapshots[(self->firstIndex + self->count) % NLR_PLAYOUT_CAPACITY];
+    snapshot->tickId = tickId;
+    snapshot->game = *authoritative;
+    self->count++;
+}
+
+static BlVector2 lerpPosition(BlVector2 a, BlVector2 b, float t)
+{
+    return blVector2AddScale(a, blVector2Sub(b, a), t);
+}
+
+/// t above one extrapolates from the two snapshots
+static void interpolate(NlGame* output, const NlrPlayoutSnapshot* a, const NlrPlayoutSnapshot* b, float t)
+{
+    *output = a->game;
+
+    size_t avatarCount = a->game.avatars.avatarCount < b->game.avatars.avatarCount ? a->game.avatars.avatarCount
+                                                                                   : b->game.avatars.avatarCount;
+    for (size_t i = 0u; i < avatarCount; ++i) {
+        const NlAvatar* avatarA = &a->game.avatars.avatars[i];
+        const NlAvatar* avatarB = &b->game.avatars.avatars[i];
+        NlAvatar* target = &output->avatars.avatars[i];
+        target->circle.center = lerpPosition(avatarA->circle.center, avatarB->circle.center, t);
+        target->visualRotation = avatarA->visualRotation +
+                                 blAngleMinimalDiff(avatarB->visualRotation, avatarA->visualRotation) * t;
+    }
+
+    output->ball.circle.center = lerpPosition(a->game.ball.circle.center, b->game.ball.circle.center, t);
+}
+
+static void advancePlayoutTime(NlrPlayout* self, uint32_t oldestTickId, uint32_t newestTickId)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (self->lastUpdateCounter != 0u) {
+        float elapsedMs = nlrMillisecondsBetween(self->lastUpdateCounter, now);
+        self->playoutTickId += (double) (elapsedMs / self->tickDurationMs);
+    }
+    self->lastUpdateCounter = now;
+
+    // Slowly speed up or slow down towards the target delay, only snap if it is way off
+    double targetTickId = (double) newestTickId - (double) self->targetDelayTicks;
+    double error = targetTickId - self->playoutTickId;
+    if (fabs(error) > snapThresholdTicks) {
+        self->playoutTickId = targetTickId;
+    } else {
+        self->playoutTickId += error * catchUpFactor;
+    }
+
+    if (self->playoutTickId < (double) oldestTickId) {
+        self->playoutTickId = (double) oldestTickId;
+    }
+
+    if (self->playoutTickId > (double) newestTickId + maximumExtrapolationTicks) {
+        self->playoutTickId = (double) newestTickId + maximumExtrapolationTicks;
+    }
+}
+
+/// Returns the game state to render this frame, or NULL if nothing has been buffered yet
+const NlGame* nlrPlayoutUpdate(NlrPlayout* self)
+{
+    if (self->count == 0u) {
+        return 0;
+    }
+
+    const NlrPlayoutSnapshot* oldest = snapshotAt(self, 0u);
+    const NlrPlayoutSnapshot* newest = snapshotAt(self, self->count - 1u);
+
+    advancePlayoutTime(self, oldest->tickId, newest->tickId);
+
+    self->isExtrapolating = self->playoutTickId > (double) newest->tickId;
+
+    if (self->count == 1u) {
+        self->output = newest->game;
+        return &self->output;
+    }
+
+    const NlrPlayoutSnapshot* a = snapshotAt(self, self->count - 2u);
+    const NlrPlayoutSnapshot* b = newest;
+    for (size_t i = 0u; i + 1u < self->count; ++i) {
+        const NlrPlayoutSnapshot* next = snapshotAt(self, i + 1u);
+        if ((double) next->tickId > self->playoutTickId) {
+            a = snapshotAt(self, i);
+            b = next;
+            break;
+        }
+    }
+
+    float t = (float) ((self->playoutTickId - (double) a->tickId) / (double) (b->tickId - a->tickId));
+    interpolate(&self->output, a, b, t);
+
+    return &self->output;
+}
+
+/// How far behind the newest buffered tick the playout currently is. Negative while extrapolating.
+double nlrPlayoutDelayTicks(const NlrPlayout* self)
+{
+    if (self->count == 0u) {
+        return 0.0;
+    }
+
+    return (double) snapshotAt(self, self->count - 1u)->tickId - self->playoutTickId;
+}
@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <clog/clog.h>
+#include <nimble-ball-presentation/quality.h>
+
+// Lowering quality reacts fast, raising it again requires a longer stable period, so the tiers don't flap
+static const float overBudgetFactor = 1.1f;
+static const float underBudgetFactor = 0.75f;
+static const int framesBeforeLowering = 30;
+static const int framesBeforeRaising = 240;
+static const float averageFactor = 0.1f;
+
+void nlrQualityGovernorInit(NlrQualityGovernor* self, float workBudgetMs)
+{
+    self->tier = NlrQualityTierFull;
+    nlrQualityGovernorSetBudget(self, workBudgetMs);
+}
+
+/// Keeps the current tier, but starts a new measurement against the new budget
+void nlrQualityGovernorSetBudget(NlrQualityGovernor* self, float workBudgetMs)
+{
+    self->workBudgetMs = workBudgetMs;
+    self->averageWorkMs = workBudgetMs;
+    self->overBudgetFrameCount = 0;
+    self->underBudgetFrameCount = 0;
+}
+
+static void changeTier(NlrQualityGovernor* self, NlrQualityTier tier)
+{
+    CLOG_VERBOSE("render quality tier %d -> %d (average work %d ms)", self->tier, tier, (int) self->averageWorkMs)
+    self->tier = tier;
+    self->overBudgetFrameCount = 0;
+    self->underBudgetFrameCount = 0;
+    // Start over from the budget, so the new tier gets a fair measurement
+    self->averageWorkMs = self->workBudgetMs;
+}
+
+/// Reports the render work of a drawn frame and returns the tier to use for the following frames
+NlrQualityTier nlrQualityGovernorUpdate(NlrQualityGovernor* self, float workMs)
+{
+    self->averageWorkMs += (workMs - self->averageWorkMs) * averageFactor;
+
+    if (self->averageWorkMs > self->workBudgetMs * overBudgetFactor) {
+        self->overBudgetFrameCount++;
+        self->underBudgetFrameCount = 0;
+    } else if (self->averageWorkMs < self->workBudgetMs * underBudgetFactor) {
+        self->underBudgetFrameCount++;
+        self->overBudgetFrameCount = 0;
+    } else {
+        self->overBudgetFrameCount = 0;
+        self->underBudgetFrameCount = 0;
+    }
+
+    if (self->overBudgetFrameCount >= framesBeforeLowering && self->tier < NlrQualityTierReducedHud) {
+        changeTier(self, (NlrQualityTier) (self->tier + 1));
+    } else if (self->underBudgetFrameCount >= framesBeforeRaising && self->tier > NlrQualityTierFull) {
+        changeTier(self, (NlrQualityTier) (self->tier - 1));
+    }
+
+    return self->tier;
+}
@@ -4,6 +4,8 @@
  *--------------------------------------------------------------------------------------------*/
 #include "basal/vector2i.h"
 #include <SDL2_image/SDL_image.h>
+#include <math.h>
+#include <nimble-ball-presentation/clock.h>
 #include <nimble-ball-presentation/render.h>
 
 static void setupAvatarSprite(SrSprite* sprite, SDL_Texture* texture, int cellIndex)
@@ -48,8 +50,15 @@ void nlRenderInit(NlRender* self, SDL_Renderer* renderer)
     SDL_Texture* avatarsTexture = IMG_LoadTexture(self->renderer, "data/avatars.png");
     SDL_Texture* equipmentTexture = IMG_LoadTexture(self->renderer, "data/equipment.png");
 
-    srFontInit(&self->font, self->renderer, "data/mouldy.ttf", 10);
-    srFontInit(&self->bigFont, self->renderer, "data/mouldy.ttf", 22);
+    // Rasterized at the size nearly all text is drawn at, larger text is scaled up from it. Minifying a large
+    // rasterization with plain linear filtering and no mip levels drops thin strokes.
+    nlrFontAtlasInit(&self->fontAtlas, self->renderer, "data/mouldy.ttf", 10);
+    nlrTextBatchClear(&self->textBatch);
+    nlrTextBatchClear(&self->hudTextBatch);
+    nlrFontInit(&self->font, &self->fontAtlas, &self->textBatch, 10.0f);
+    nlrFontInit(&self->bigFont, &self->fontAtlas, &self->textBatch, 22.0f);
+    nlrFontInit(&self->hudFont, &self->fontAtlas, &self->hudTextBatch, 10.0f);
+    nlrFontInit(&self->hudBigFont, &self->fontAtlas, &self->hudTextBatch, 22.0f);
 
     for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
         self->players[i].info.isUsed = false;
@@ -72,15 +81,61 @@ void nlRenderInit(NlRender* self, SDL_Renderer* renderer)
     setupJerseySprite(&self->jerseySprite[0], equipmentTexture, 0);
     setupJerseySprite(&self->jerseySprite[1], equipmentTexture, 1);
     self->mode = NlRenderModePredicted;
+    self->shadowDivergenceThreshold = 1.0f;
+    self->divergence.maxAvatarError = 0.0f;
+    self->divergence.ballError = 0.0f;
+    self->divergence.divergentAvatarCount = 0u;
+
+    nlrAnimationsInit(&self->animations);
+    nlrAnimationsLoad(&self->animations, "data/animations.txt");
+    self->ballSpawnClip = nlrAnimationsFindClip(&self->animations, "ball_spawn");
+    NlrEffectClips effectClips;
+    effectClips.ballImpact = nlrAnimationsFindClip(&self->animations, "ball_impact");
+    effectClips.avatarSpawned = nlrAnimationsFindClip(&self->animations, "avatar_spawn");
+    effectClips.playerJoined = nlrAnimationsFindClip(&self->animations, "player_joined");
+    effectClips.playerLeft = nlrAnimationsFindClip(&self->animations, "player_left");
+    nlrEffectsInit(&self->effects, effectClips);
+    self->effectsMode = self->mode;
+    self->tickId = 0u;
+    self->frameCount = 0u;
+    // Half of a 60 Hz frame, leaving the rest for the simulation and the present
+    nlrQualityGovernorInit(&self->quality, 1000.0f / 60.0f / 2.0f);
+    nlrPlayoutInit(&self->playout, 16.0f);
+    self->isAuthoritativeFedExplicitly = false;
+    self->telemetry.ring = 0;
+    self->isSkippingIdleFrames = false;
+    self->lastSceneHash = 0u;
+    self->lastHudHash = 0u;
+    self->lastStatsHash = 0u;
+    self->lastStatsRedrawCounter = 0u;
+    self->settleFramesLeft = 0u;
+    self->lastDrawnTickId = 0u;
+    self->isLocalInputExtrapolated = false;
+    self->lastPredictedTickId = 0u;
+    self->predictedTickCounter = 0u;
+
+    BlVector2 arenaMin = g_nlConstants.borderSegments[0].a;
+    BlVector2 arenaMax = arenaMin;
+    for (size_t i = 0; i < sizeof(g_nlConstants.borderSegments) / sizeof(g_nlConstants.borderSegments[0]); ++i) {
+        const BlLineSegment* lineSegment = &g_nlConstants.borderSegments[i];
+        arenaMin.x = fminf(arenaMin.x, fminf(lineSegment->a.x, lineSegment->b.x));
+        arenaMin.y = fminf(arenaMin.y, fminf(lineSegment->a.y, lineSegment->b.y));
+        arenaMax.x = fmaxf(arenaMax.x, fmaxf(lineSegment->a.x, lineSegment->b.x));
+        arenaMax.y = fmaxf(arenaMax.y, fmaxf(lineSegment->a.y, lineSegment->b.y));
+    }
+    nlrCameraInit(&self->camera, arenaMin, arenaMax);
+    nlrViewportInit(&self->viewport, self->renderer);
 }
 
-static BlVector2i simulationToRender(BlVector2 pos)
+static BlVector2i simulationToRender(const NlrCamera* camera, BlVector2 pos)
 {
-    BlVector2i result;
-    result.x = (int) pos.x;
-    result.y = (int) pos.y;
+    return nlrCameraWorldToLogical(camera, pos);
+}
 
-    return result;
+static float spriteRadius(const SrSprite* sprite, float scale)
+{
+    int largestSide = sprite->rect.w > sprite->rect.h ? sprite->rect.w : sprite->rect.h;
+    return (float) largestSide * scale / 2.0f;
 }
 
 static SDL_Color getTeamColor(int teamIndex)
@@ -105,70 +160,79 @@ static SDL_Color getTeamColor(int teamIndex)
     return teamColor;
 }
 
-static void renderGoals(SrRects* rectangleRender, const NlConstants* constants)
+static void renderGoals(SrRects* rectangleRender, const NlrCamera* camera, const NlConstants* constants)
 {
     for (size_t i = 0; i < 2; ++i) {
         const NlGoal* goal = &constants->goals[i];
+        if (!nlrCameraIsRectVisible(camera, goal->rect.position, goal->rect.size)) {
+            continue;
+        }
 
         SDL_Color teamColor = getTeamColor(goal->ownedByTeam);
         SDL_SetRenderDrawColor(rectangleRender->renderer, teamColor.r, teamColor.g, teamColor.b, teamColor.a);
 
-        srRectsLineRect(rectangleRender, (int) goal->rect.position.x, (int) goal->rect.position.y,
-                        (int) goal->rect.size.x, (int) goal->rect.size.y);
+        BlVector2i position = simulationToRender(camera, goal->rect.position);
+        srRectsLineRect(rectangleRender, position.x, position.y, (int) (goal->rect.size.x * camera->zoom),
+                        (int) (goal->rect.size.y * camera->zoom));
     }
 }
 
-static void renderBorders(SrRects* lineRender, const NlConstants* constants)
+static void renderBorders(SrRects* lineRender, const NlrCamera* camera, const NlConstants* constants)
 {
     SDL_SetRenderDrawColor(lineRender->renderer, 255, 240, 127, SDL_ALPHA_OPAQUE);
     for (size_t i = 0; i < sizeof(constants->borderSegments) / sizeof(constants->borderSegments[0]); ++i) {
         const BlLineSegment* lineSegment = &constants->borderSegments[i];
-        srRectsDrawLine(lineRender, (int) lineSegment->a.x, (int) lineSegment->a.y, (int) lineSegment->b.x,
-                        (int) lineSegment->b.y);
+        if (!nlrCameraIsSegmentVisible(camera, lineSegment->a, lineSegment->b)) {
+            continue;
+        }
+        BlVector2i a = simulationToRender(camera, lineSegment->a);
+        BlVector2i b = simulationToRender(camera, lineSegment->b);
+        srRectsDrawLine(lineRender, a.x, a.y, b.x, b.y);
     }
 }
 
-static void renderTeamNameAndScore(const SrFont* font, const NlTeam* team, int teamIndex, const char* teamName,
-                                   SDL_Color teamColor)
+static void renderTeamNameAndScore(const NlrFont* font, const NlTeam* team, int teamIndex,
+                                   const char* teamName, SDL_Color teamColor)
 {
-    int teamX = teamIndex == 0 ? 50 : 540;
-    int startY = 330;
+    int teamX = teamIndex == 0 ? 50 : NLR_LOGICAL_WIDTH - 100;
+    int startY = NLR_LOGICAL_HEIGHT - 30;
 
-    srFontRenderAndCopy(font, teamName, teamX, startY, teamColor);
+    nlrFontDrawText(font, teamName, teamX, startY, teamColor);
 
     char scoreText[16];
 
     tc_snprintf(scoreText, 16, "%d", team->score);
-    srFontRenderAndCopy(font, scoreText, teamX + 10, startY - 12, teamColor);
+    nlrFontDrawText(font, scoreText, teamX + 10, startY - 12, teamColor);
 }
 
-static void renderTeamHud(const SrFont* font, const NlTeam* team, int teamIndex, const char* teamName)
+static void renderTeamHud(const NlrFont* font, const NlTeam* team, int teamIndex, const char* teamName)
 {
     SDL_Color teamColor = getTeamColor(teamIndex);
 
     renderTeamNameAndScore(font, team, teamIndex, teamName, teamColor);
 }
 
-static void renderCountDown(const SrFont* font, uint8_t countDown)
+static void renderCountDown(const NlrFont* font, uint8_t countDown)
 {
     int approximateSecondsLeft = (countDown / 62) + 1;
     char secondsText[16];
     tc_snprintf(secondsText, 16, "%d", approximateSecondsLeft);
     SDL_Color secondsColor = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
-    srFontRenderAndCopy(font, secondsText, 300, 230, secondsColor);
+    nlrFontDrawText(font, secondsText, NLR_LOGICAL_WIDTH / 2 - 20, NLR_LOGICAL_HEIGHT / 2 + 50, secondsColor);
 }
 
-static void renderGoalCelebration(const SrFont* font, int teamIndexThatScored)
+static void renderGoalCelebration(const NlrFont* font, int teamIndexThatScored)
 {
     SDL_Color goalCelebrationColor = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
-    srFontRenderAndCopy(font, "GOAL!", 300, 210, goalCelebrationColor);
+    nlrFontDrawText(font, "GOAL!", NLR_LOGICAL_WIDTH / 2 - 20, NLR_LOGICAL_HEIGHT / 2 + 30, goalCelebrationColor);
 
     const char* goalAnnouncement[] = {"Red Scored!", "Blue Scored!"};
     SDL_Color teamColor = getTeamColor(teamIndexThatScored);
-    srFontRenderAndCopy(font, goalAnnouncement[teamIndexThatScored], 180, 170, teamColor);
+    nlrFontDrawText(font, goalAnnouncement[teamIndexThatScored], NLR_LOGICAL_WIDTH / 2 - 140,
+                    NLR_LOGICAL_HEIGHT / 2 - 10, teamColor);
 }
 
-static void renderPostGame(const SrFont* font, const NlTeams* teams)
+static void renderPostGame(const NlrFont* font, const NlTeams* teams)
 {
     int winningTeam = teams->teams[0].score > teams->teams[1].score   ? 0
                       : teams->teams[1].score > teams->teams[0].score ? 1
@@ -187,10 +251,11 @@ static void renderPostGame(const SrFont* font, const NlTeams* teams)
     }
     const char* winAnnouncement = winAnnouncements[winningTeam + 1];
 
-    srFontRenderAndCopy(font, winAnnouncement, 220, 230, winAnnouncementColor);
+    nlrFontDrawText(font, winAnnouncement, NLR_LOGICAL_WIDTH / 2 - 100, NLR_LOGICAL_HEIGHT / 2 + 50,
+                    winAnnouncementColor);
 }
 
-static void renderGameClock(const SrFont* font, uint16_t gameClockLeftInTicks)
+static void renderGameClock(const NlrFont* font, uint16_t gameClockLeftInTicks)
 {
     int milliSecondsLeftInGame = gameClockLeftInTicks * 16;
 
@@ -202,10 +267,10 @@ static void renderGameClock(const SrFont* font, uint16_t gameClockLeftInTicks)
     tc_snprintf(gameClockText, 64, "%02d:%02d:%03d", minutesLeft, secondsLeft, millisecondsLeft);
 
     SDL_Color gameClockColor = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
-    srFontRenderAndCopy(font, gameClockText, 260, 330, gameClockColor);
+    nlrFontDrawText(font, gameClockText, NLR_LOGICAL_WIDTH / 2 - 60, NLR_LOGICAL_HEIGHT - 30, gameClockColor);
 }
 
-static void renderHud(const SrFont* font, const SrFont* bigFont, const NlGame* authoritative, const NlGame* predicted)
+static void renderHud(const NlrFont* font, const NlrFont* bigFont, const NlGame* authoritative, const NlGame* predicted)
 {
     if (authoritative->teams.teamCount == 2) {
         renderTeamHud(font, &authoritative->teams.teams[0], 0, "Red");
@@ -233,31 +298,51 @@ static void renderHud(const SrFont* font, const SrFont* bigFont, const NlGame* a
     renderGameClock(font, predicted->matchClockLeftInTicks);
 }
 
-static void renderStats(NlRender* self)
+static const int statsBorderSize = 22;
+static const int statsTopY = NLR_LOGICAL_HEIGHT - 1;
+
+static void renderStatsBackground(NlRender* self)
 {
     SDL_SetRenderDrawColor(self->renderer, 0x44, 0x22, 0x44, 0x22);
-    const int borderSize = 22;
-    srRectsFillRect(&self->rectangleRender, 0, 359 - borderSize, 640, borderSize);
+    srRectsFillRect(&self->rectangleRender, 0, statsTopY - statsBorderSize, NLR_LOGICAL_WIDTH, statsBorderSize);
+}
+
+static void renderStats(NlRender* self)
+{
     char buf[512];
-    tc_snprintf(buf, 512, "preId %04X autId %04X conBufCnt %d fps:%d latency:%d", self->stats.predictedTickId,
-                self->stats.authoritativeTickId, self->stats.authoritativeStepsInBuffer, self->stats.renderFps,
-                self->stats.latencyMs);
+    tc_snprintf(buf, 512, "preId %04X autId %04X conBufCnt %d fps:%d latency:%d div:%d/%.1f q:%d",
+                self->stats.predictedTickId, self->stats.authoritativeTickId, self->stats.authoritativeStepsInBuffer,
+                self->stats.renderFps, self->stats.latencyMs, self->stats.divergentAvatarCount,
+                (double) self->stats.maxAvatarDivergence, self->stats.qualityTier);
     SDL_Color color = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
-    srFontRenderAndCopy(&self->font, buf, 10, 359 - 6, color);
+    nlrFontDrawText(&self->hudFont, buf, 10, statsTopY - 6, color);
 }
 
 #include <basal/math.h>
 
 static const float lerpFactor = 1.0f;
 
-static void renderAvatar(NlRender* self, NlrAvatar* renderAvatar, const NlAvatar* avatar, Uint8 alpha)
+static float animationScale(const NlRender* self, int animationIndex)
+{
+    const NlrAnimationInstance* instance = nlrAnimationsInstance(&self->animations, animationIndex);
+    return instance == 0 ? 1.0f : instance->scale;
+}
+
+static float effectScale(const NlRender* self, NlrEffectKind kind, size_t key)
+{
+    const NlrEffect* effect = nlrEffectsFind(&self->effects, kind, (uint8_t) key);
+    return effect == 0 ? 1.0f : animationScale(self, effect->animation);
+}
+
+static void updateAvatar(NlrAvatar* renderAvatar, const NlAvatar* avatar)
 {
-    const size_t avatarSpawnTime = 60u;
     if (!renderAvatar->info.isUsed) {
         renderAvatar->info.isUsed = true;
-        renderAvatar->spawnCountDown = avatarSpawnTime;
         renderAvatar->precisionPosition = avatar->circle.center;
         renderAvatar->rotation = avatar->visualRotation;
+        renderAvatar->leadOffset.x = 0.0f;
+        renderAvatar->leadOffset.y = 0.0f;
+        renderAvatar->rotationLead = 0.0f;
     }
 
     BlVector2 targetPosition = avatar->circle.center;
@@ -271,74 +356,106 @@ static void renderAvatar(NlRender* self, NlrAvatar* renderAvatar, const NlAvatar
     float diffThisTick = blFabs(angleDiff) > maxRadianDiffPerTime ? blFSign(angleDiff) * maxRadianDiffPerTime
                                                                   : angleDiff;
     renderAvatar->rotation += diffThisTick;
+}
 
-    if (renderAvatar->spawnCountDown > 0u) {
-        renderAvatar->spawnCountDown--;
+static void drawAvatar(NlRender* self, const NlrAvatar* renderAvatar, const NlAvatar* avatar, size_t avatarIndex,
+                       Uint8 alpha)
+{
+    // Shadows share the spawn of the main state avatar in the same slot
+    float scale = effectScale(self, NlrEffectKindAvatarSpawned, avatarIndex);
+
+    const SrSprite* avatarSprite = &self->avatarSpriteForTeam[avatar->teamIndex];
+    scale *= self->camera.zoom;
+    BlVector2 position = blVector2AddScale(renderAvatar->precisionPosition, renderAvatar->leadOffset, 1.0f);
+    if (!nlrCameraIsCircleVisible(&self->camera, position, spriteRadius(avatarSprite, scale))) {
+        return;
     }
 
-    float scale = renderAvatar->spawnCountDown > 0u ? 1.0f - renderAvatar->spawnCountDown / (float) avatarSpawnTime
-                                                    : 1.0f;
-
-    BlVector2i avatarRenderPos = simulationToRender(renderAvatar->precisionPosition);
-    int degreesAngle = (int) (renderAvatar->rotation * 360.0f / ((float) M_PI * 2.0f));
+    BlVector2i avatarRenderPos = simulationToRender(&self->camera, position);
+    float rotation = renderAvatar->rotation + renderAvatar->rotationLead;
+    int degreesAngle = (int) (rotation * 360.0f / ((float) M_PI * 2.0f));
 
     if (avatar->isInvisible) {
         alpha = 0x20;
     }
 
-    srSpritesCopyEx(&self->spriteRender, &self->avatarSpriteForTeam[avatar->teamIndex], avatarRenderPos.x,
-                    avatarRenderPos.y, degreesAngle, scale, alpha);
+    srSpritesCopyEx(&self->spriteRender, avatarSprite, avatarRenderPos.x, avatarRenderPos.y, degreesAngle, scale,
+                    alpha);
+}
+
+/// Slots without an avatar are released, so an avatar that shows up there again starts from its own position
+static void releaseAvatars(NlrAvatar* nlrAvatars, const NlAvatars* avatars)
+{
+    for (size_t i = avatars->avatarCount; i < NL_MAX_PLAYERS; ++i) {
+        nlrAvatars[i].info.isUsed = false;
+    }
 }
 
 static void renderAvatars(NlRender* self, NlrAvatar* nlrAvatars, const NlAvatars* avatars, Uint8 alpha)
 {
+    releaseAvatars(nlrAvatars, avatars);
     for (size_t i = 0u; i < avatars->avatarCount; ++i) {
         const NlAvatar* avatar = &avatars->avatars[i];
         NlrAvatar* nlrAvatar = &nlrAvatars[i];
-        renderAvatar(self, nlrAvatar, avatar, alpha);
+        updateAvatar(nlrAvatar, avatar);
+        drawAvatar(self, nlrAvatar, avatar, i, alpha);
     }
 }
 
-static void renderBall(NlRender* self, NlrBall* nlrBall, const NlBall* ball, Uint8 alpha)
+static void renderShadowAvatars(NlRender* self, const NlAvatars* avatars, Uint8 alpha)
+{
+    releaseAvatars(self->shadowAvatars, avatars);
+    for (size_t i = 0u; i < avatars->avatarCount; ++i) {
+        const NlAvatar* avatar = &avatars->avatars[i];
+        NlrAvatar* nlrAvatar = &self->shadowAvatars[i];
+        // Keep the shadow state in sync, so it doesn't snap when it starts to diverge
+        updateAvatar(nlrAvatar, avatar);
+        if (self->quality.tier < NlrQualityTierNoShadows && self->divergence.isAvatarDivergent[i]) {
+            drawAvatar(self, nlrAvatar, avatar, i, alpha);
+        }
+    }
+}
+
+static void updateBall(NlRender* self, NlrBall* nlrBall, const NlBall* ball)
 {
     if (!nlrBall->info.isUsed) {
         nlrBall->info.isUsed = true;
-        nlrBall->spawnCountDown = 60u;
-        nlrBall->simulationCollideCounter = ball->collideCounter;
+        nlrBall->spawnAnimation = nlrAnimationsStart(&self->animations, self->ballSpawnClip, self->tickId);
         nlrBall->precisionPosition = ball->circle.center;
     }
     BlVector2 ballRenderTargetPos = ball->circle.center;
 
-    if (nlrBall->spawnCountDown > 0) {
-        nlrBall->spawnCountDown--;
-    }
-    const size_t impactTime = 12u;
-    if (ball->collideCounter != nlrBall->simulationCollideCounter) {
-        nlrBall->simulationCollideCounter = ball->collideCounter;
-        nlrBall->lastCollisionCountDown = impactTime;
-        nlrBall->lastImpactPosition.x = (int) ballRenderTargetPos.x;
-        nlrBall->lastImpactPosition.y = (int) ballRenderTargetPos.y;
+    const NlrAnimationInstance* spawn = nlrAnimationsInstance(&self->animations, nlrBall->spawnAnimation);
+    if (spawn != 0 && spawn->isDone) {
+        nlrAnimationsStop(&self->animations, &nlrBall->spawnAnimation);
     }
 
+
     BlVector2 delta = blVector2Sub(ballRenderTargetPos, nlrBall->precisionPosition);
     nlrBall->precisionPosition = blVector2AddScale(nlrBall->precisionPosition, delta, lerpFactor);
+}
 
-    float scale = nlrBall->spawnCountDown > 0u ? 1.0f - (float) nlrBall->spawnCountDown / 60.0f : 1.0f;
+static void drawBall(NlRender* self, NlrBall* nlrBall, Uint8 alpha)
+{
+    float scale = animationScale(self, nlrBall->spawnAnimation) * self->camera.zoom;
+
+    if (nlrCameraIsCircleVisible(&self->camera, nlrBall->precisionPosition, spriteRadius(&self->ballSprite, scale))) {
+        BlVector2i ballRenderPos = simulationToRender(&self->camera, nlrBall->precisionPosition);
+        srSpritesCopyEx(&self->spriteRender, &self->ballSprite, ballRenderPos.x, ballRenderPos.y, 0, scale, alpha);
+    }
+}
 
-    srSpritesCopyEx(&self->spriteRender, &self->ballSprite, (int) nlrBall->precisionPosition.x,
-                    (int) nlrBall->precisionPosition.y, 0, scale, alpha);
+static void renderBall(NlRender* self, NlrBall* nlrBall, const NlBall* ball, Uint8 alpha)
+{
+    updateBall(self, nlrBall, ball);
+    drawBall(self, nlrBall, alpha);
+}
 
-    if (nlrBall->lastCollisionCountDown > 0u && alpha == SDL_ALPHA_OPAQUE) {
-        nlrBall->lastCollisionCountDown--;
-        SrSprite ballCollideSprite = self->ballSprite;
-        float normalizedTime = 1.0f - (float) nlrBall->lastCollisionCountDown / (float) impactTime;
-        int spriteSheetIndex = (int) (normalizedTime * 2.9f);
-        ballCollideSprite.rect.x = (spriteSheetIndex + 2) * 16;
-        ballCollideSprite.rect.y = 0;
-        ballCollideSprite.rect.w = 16;
-        ballCollideSprite.rect.h = 16;
-        srSpritesCopyEx(&self->spriteRender, &ballCollideSprite, nlrBall->lastImpactPosition.x,
-                        nlrBall->lastImpactPosition.y, 0, 1.0f, 0xff);
+static void renderShadowBall(NlRender* self, const NlBall* ball, Uint8 alpha)
+{
+    updateBall(self, &self->shadowBall, ball);
+    if (self->quality.tier < NlrQualityTierNoShadows && self->divergence.ballError >= self->shadowDivergenceThreshold) {
+        drawBall(self, &self->shadowBall, alpha);
     }
 }
 
@@ -347,15 +464,71 @@ static void renderBalls(NlRender* self, const NlGame* predicted, Uint8 alpha)
     renderBall(self, &self->ball, &predicted->ball, alpha);
 }
 
-static void renderLocalAvatarArrow(NlRender* self, const NlAvatar* avatar)
+static void renderBallImpact(NlRender* self, const NlrEffect* effect)
 {
-    int x = (int) avatar->circle.center.x;
-    int y = (int) (avatar->circle.center.y + 26);
+    const NlrAnimationInstance* impact = nlrAnimationsInstance(&self->animations, effect->animation);
+    if (impact == 0) {
+        return;
+    }
 
-    srSpritesCopyEx(&self->spriteRender, &self->arrowSprite, x, y, 0, 1.0f, 0xff);
+    const SDL_Rect* impactFrame = nlrAnimationsFrame(&self->animations, impact);
+    if (impactFrame == 0) {
+        return;
+    }
+
+    SrSprite ballCollideSprite = self->ballSprite;
+    ballCollideSprite.rect = *impactFrame;
+    float impactScale = impact->scale * self->camera.zoom;
+    if (!nlrCameraIsCircleVisible(&self->camera, effect->position, spriteRadius(&ballCollideSprite, impactScale))) {
+        return;
+    }
+
+    BlVector2i impactRenderPos = simulationToRender(&self->camera, effect->position);
+    srSpritesCopyEx(&self->spriteRender, &ballCollideSprite, impactRenderPos.x, impactRenderPos.y, 0, impactScale,
+                    impact->alpha);
 }
 
-static void renderMenus(NlRender* render, const SrFont* font, const SrFont* bigFont, const NlGame* predicted,
+static void renderEffects(NlRender* self)
+{
+    if (self->quality.tier >= NlrQualityTierNoEffects) {
+        return;
+    }
+
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        const NlrEffect* effect = &self->effects.effects[i];
+        // Effects recorded for ticks that are not rendered yet (e.g. after a mode switch) wait for their tick
+        if (!effect->isUsed || (int32_t) (self->tickId - effect->tickId) < 0) {
+            continue;
+        }
+
+        switch (effect->kind) {
+            case NlrEffectKindBallImpact:
+                renderBallImpact(self, effect);
+                break;
+            // Spawns and banners are drawn together with their avatar and player
+            case NlrEffectKindAvatarSpawned:
+            case NlrEffectKindAvatarRemoved:
+            case NlrEffectKindPlayerJoined:
+            case NlrEffectKindPlayerLeft:
+                break;
+        }
+    }
+}
+
+static void renderLocalAvatarArrow(NlRender* self, const NlrAvatar* renderAvatar)
+{
+    BlVector2 arrowPosition = blVector2AddScale(renderAvatar->precisionPosition, renderAvatar->leadOffset, 1.0f);
+    arrowPosition.y += 26;
+    if (!nlrCameraIsCircleVisible(&self->camera, arrowPosition, spriteRadius(&self->arrowSprite, self->camera.zoom))) {
+        return;
+    }
+
+    BlVector2i arrowRenderPos = simulationToRender(&self->camera, arrowPosition);
+    srSpritesCopyEx(&self->spriteRender, &self->arrowSprite, arrowRenderPos.x, arrowRenderPos.y, 0,
+                    self->camera.zoom, 0xff);
+}
+
+static void renderMenus(NlRender* render, const NlrFont* font, const NlrFont* bigFont, const NlGame* predicted,
                         const NlPlayer* player, NlrLocalPlayer* renderPlayer)
 {
     (void) bigFont;
@@ -371,7 +544,7 @@ static void renderMenus(NlRender* render, const SrFont* font, const SrFont* bigF
 
             srRectsFillRect(&render->rectangleRender, backgroundX, backgroundY, 400, 200);
             SDL_Color secondsColor = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
-            srFontRenderAndCopy(font, "SELECT YOUR TEAM!", 200, 280, secondsColor);
+            nlrFontDrawText(font, "SELECT YOUR TEAM!", 200, 280, secondsColor);
             int jerseyY = 200;
             const float selectedScale = 4.0f;
             const float notSelectedScale = 3.0f;
@@ -388,7 +561,7 @@ static void renderMenus(NlRender* render, const SrFont* font, const SrFont* bigF
                                    backgroundColor.a);
             srRectsFillRect(&render->rectangleRender, backgroundX, backgroundY, 400, 200);
             SDL_Color secondsColor = {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE};
-            srFontRenderAndCopy(font, "Team selected. Waiting for Countdown", 30, 280, secondsColor);
+            nlrFontDrawText(font, "Team selected. Waiting for Countdown", 30, 280, secondsColor);
         } break;
         case NlPlayerPhasePlaying:
 
@@ -429,55 +602,59 @@ static void renderForLocalParticipants(NlRender* render, const NlGame* predicted
             continue;
         }
 
-        const NlAvatar* avatar = &predicted->avatars.avatars[avatarIndex];
-        renderLocalAvatarArrow(render, avatar);
+        renderLocalAvatarArrow(render, &render->avatars[avatarIndex]);
     }
 }
 
-static void renderPlayer(NlRender* render, NlrPlayer* renderPlayer, const NlPlayer* player)
+static void renderPlayerBanner(NlRender* render, const NlrPlayer* player, const char* action,
+                               const NlrAnimationInstance* banner)
 {
-    if (!renderPlayer->info.isUsed) {
-        renderPlayer->info.isUsed = true;
-        renderPlayer->countDown = 180;
-        renderPlayer->destroyCountdown = 0;
-        // renderPlayer->participantId = player->assignedToParticipantIndex;
-    }
-
-    if (renderPlayer->countDown > 0) {
-        renderPlayer->countDown--;
-
-        SDL_Color playerJoinedColor = getTeamColor(player->preferredTeamId);
-        char buf[32];
-        tc_snprintf(buf, 32, "player %d joined", player->playerIndex);
-        srFontRenderAndCopy(&render->font, buf, 14, 15, playerJoinedColor);
-    }
-
-    if (renderPlayer->destroyCountdown > 0) {
-        renderPlayer->destroyCountdown--;
-        if (renderPlayer->destroyCountdown == 0) {
-            renderPlayer->info.isUsed = false;
-        }
-
-        SDL_Color playerJoinedColor = getTeamColor(player->preferredTeamId);
-        char buf[32];
-        tc_snprintf(buf, 32, "player %d left", player->playerIndex);
-        srFontRenderAndCopy(&render->font, buf, 14, 15, playerJoinedColor);
-    }
+    SDL_Color playerBannerColor = getTeamColor(player->preferredTeamId);
+    playerBannerColor.a = banner->alpha;
+    char buf[32];
+    tc_snprintf(buf, 32, "player %d %s", player->playerIndex, action);
+    nlrFontAtlasDrawText(&render->fontAtlas, &render->textBatch, buf, 14, 15, render->font.size * banner->scale,
+                         playerBannerColor);
 }
 
+/// Banners are driven by the joined and left events in the effects log, so rolled back joins and leaves vanish
 static void renderPlayers(NlRender* render, const NlPlayers* players)
 {
-    for (size_t i = 0U; i < NL_MAX_PLAYERS; ++i) {
+    // Remember who was in each slot, the banner for a player that left is shown after it is gone from the state
+    for (size_t i = 0u; i < players->playerCount; ++i) {
+        const NlPlayer* player = &players->players[i];
         NlrPlayer* renderPlayer = &render->players[i];
+        renderPlayer->info.isUsed = true;
+        renderPlayer->playerIndex = player->playerIndex;
+        renderPlayer->preferredTeamId = player->preferredTeamId;
+    }
+
+    for (size_t i = 0u; i < NLR_MAX_EFFECTS; ++i) {
+        const NlrEffect* effect = &render->effects.effects[i];
+        if (!effect->isUsed || (int32_t) (render->tickId - effect->tickId) < 0) {
+            continue;
+        }
 
-        if (renderPlayer->info.isUsed && i >= players->playerCount && renderPlayer->destroyCountdown == 0) {
-            renderPlayer->destroyCountdown = 120U;
+        const char* action;
+        switch (effect->kind) {
+            case NlrEffectKindPlayerJoined:
+                action = "joined";
+                break;
+            case NlrEffectKindPlayerLeft:
+                action = "left";
+                break;
+            case NlrEffectKindBallImpact:
+            case NlrEffectKindAvatarSpawned:
+            case NlrEffectKindAvatarRemoved:
+                continue;
         }
-    }
 
-    for (size_t i = 0u; i < players->playerCount; ++i) {
-        const NlPlayer* player = &players->players[i];
-        renderPlayer(render, &render->players[i], player);
+        const NlrAnimationInstance* banner = nlrAnimationsInstance(&render->animations, effect->animation);
+        const NlrPlayer* renderPlayer = &render->players[effect->key];
+        if (banner == 0 || banner->isDone || !renderPlayer->info.isUsed) {
+            continue;
+        }
+        renderPlayerBanner(render, renderPlayer, action, banner);
     }
 }
 
@@ -513,9 +690,353 @@ static void spawnLocalPlayersIfNeeded(NlRender* self, const uint8_t localPartici
     }
 }
 
-void nlRenderUpdate(NlRender* self, const NlGame* authoritative, const NlGame* predicted,
+/// How far into the current tick we are, from 0 when a new prediction arrived, to 1 when the next one is due
+static float predictedTickFraction(NlRender* self, uint32_t predictedTickId, float tickDurationMs)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (predictedTickId != self->lastPredictedTickId || self->predictedTickCounter == 0u) {
+        self->lastPredictedTickId = predictedTickId;
+        self->predictedTickCounter = now;
+        return 0.0f;
+    }
+
+    float fraction = nlrMillisecondsBetween(self->predictedTickCounter, now) / tickDurationMs;
+
+    return fraction > 1.0f ? 1.0f : fraction;
+}
+
+static void targetLocalAvatarLead(const NlrAvatar* renderAvatar, const SrGamepad* gamepad, float tickFraction,
+                                  BlVector2* targetOffset, float* targetRotation)
+{
+    // Roughly the distance an avatar at full speed covers in one tick
+    const float maxLeadDistance = 2.0f;
+    const float maxRotationLead = 0.1f;
+
+    float horizontal = (float) gamepad->horizontalAxis;
+    float vertical = (float) gamepad->verticalAxis;
+    float length = sqrtf(horizontal * horizontal + vertical * vertical);
+    if (length <= 0.0f) {
+        return;
+    }
+
+    BlVector2 direction;
+    direction.x = horizontal / length;
+    direction.y = vertical / length;
+    *targetOffset = blVector2AddScale(*targetOffset, direction, maxLeadDistance * tickFraction);
+
+    float angleDiff = blAngleMinimalDiff(atan2f(direction.y, direction.x), renderAvatar->rotation);
+    float rotationLead = blFabs(angleDiff) > maxRotationLead ? blFSign(angleDiff) * maxRotationLead : angleDiff;
+    *targetRotation = rotationLead * tickFraction;
+}
+
+/// A new predicted tick moves the avatar base position, usually about as far as the lead did. Remove the part of that
+/// movement that goes along the lead from the lead, so the drawn position doesn't jump ahead at the tick boundary.
+/// Never removes more than the lead itself, so other movement is not turned into a lag.
+static void consumeLeadWithBaseMovement(NlrAvatar* renderAvatar, const NlAvatar* avatar)
+{
+    BlVector2 lead = renderAvatar->leadOffset;
+    float leadLength = sqrtf(lead.x * lead.x + lead.y * lead.y);
+    if (leadLength <= 0.0f) {
+        return;
+    }
+
+    // Same movement that updateAvatar() applies to the base position this frame
+    BlVector2 baseMovement = blVector2Sub(avatar->circle.center, renderAvatar->precisionPosition);
+    baseMovement.x *= lerpFactor;
+    baseMovement.y *= lerpFactor;
+
+    float movementAlongLead = (baseMovement.x * lead.x + baseMovement.y * lead.y) / leadLength;
+    if (movementAlongLead <= 0.0f) {
+        return;
+    }
+    float consumed = movementAlongLead > leadLength ? leadLength : movementAlongLead;
+    renderAvatar->leadOffset = blVector2AddScale(lead, lead, -consumed / leadLength);
+}
+
+/// The simulation only sees new input on the next tick. Lead the avatars controlled on this machine with the latest
+/// gamepad state, so the perceived input latency drops by up to one tick. Never affects the simulation.
+static void updateLocalAvatarLeads(NlRender* self, const NlGame* game, uint32_t predictedTickId,
+                                   const uint8_t localParticipants[], size_t participantCount)
+{
+    const float leadLerpFactor = 0.3f;
+    // Small enough to not be visible, keeps a decayed lead from changing the frame hash forever
+    const float leadSnapEpsilon = 0.01f;
+
+    bool isNewPredictedTick = predictedTickId != self->lastPredictedTickId;
+
+    BlVector2 targetOffsets[NL_MAX_PLAYERS];
+    float targetRotations[NL_MAX_PLAYERS];
+    for (size_t i = 0u; i < NL_MAX_PLAYERS; ++i) {
+        targetOffsets[i].x = 0.0f;
+        targetOffsets[i].y = 0.0f;
+        targetRotations[i] = 0.0f;
+    }
+
+    // Only the predicted state is ahead of the authoritative state, leading a delayed playout makes no sense
+    if (self->isLocalInputExtrapolated && self->mode == NlRenderModePredicted) {
+        float tickFraction = predictedTickFraction(self, predictedTickId, self->playout.tickDurationMs);
+        for (size_t i = 0u; i < participantCount; ++i) {
+            const NlrLocalPlayer* localPlayer = nlRenderFindLocalPlayerFromParticipantId(self, localParticipants[i]);
+            const NlPlayer* player = nlGameFindSimulationPlayerFromParticipantId(game, localParticipants[i]);
+            if (localPlayer == 0 || player == 0 || player->controllingAvatarIndex >= game->avatars.avatarCount) {
+                continue;
+            }
+            uint8_t avatarIndex = player->controllingAvatarIndex;
+            targetLocalAvatarLead(&self->avatars[avatarIndex], &localPlayer->gamepad, tickFraction,
+                                  &targetOffsets[avatarIndex], &targetRotations[avatarIndex]);
+        }
+    }
+
+    for (size_t i = 0u; i < game->avatars.avatarCount; ++i) {
+        NlrAvatar* renderAvatar = &self->avatars[i];
+        if (!renderAvatar->info.isUsed) {
+            continue;
+        }
+
+        if (isNewPredictedTick) {
+            consumeLeadWithBaseMovement(renderAvatar, &game->avatars.avatars[i]);
+        }
+
+        BlVector2 delta = blVector2Sub(targetOffsets[i], renderAvatar->leadOffset);
+        renderAvatar->leadOffset = blVector2AddScale(renderAvatar->leadOffset, delta, leadLerpFactor);
+        renderAvatar->rotationLead += (targetRotations[i] - renderAvatar->rotationLead) * leadLerpFactor;
+
+        BlVector2 offset = renderAvatar->leadOffset;
+        if (sqrtf(offset.x * offset.x + offset.y * offset.y) < leadSnapEpsilon) {
+            renderAvatar->leadOffset.x = 0.0f;
+            renderAvatar->leadOffset.y = 0.0f;
+        }
+        if (blFabs(renderAvatar->rotationLead) < leadSnapEpsilon) {
+            renderAvatar->rotationLead = 0.0f;
+        }
+    }
+}
+
+static BlVector2 cameraFollowTarget(const NlRender* self, const NlGame* game, const uint8_t localParticipants[],
+                                    size_t participantCount)
+{
+    if (self->camera.follow == NlrCameraFollowLocalAvatar && participantCount > 0) {
+        const NlPlayer* player = nlGameFindSimulationPlayerFromParticipantId(game, localParticipants[0]);
+        if (player != 0 && player->controllingAvatarIndex != NL_AVATAR_INDEX_UNDEFINED) {
+            return game->avatars.avatars[player->controllingAvatarIndex].circle.center;
+        }
+    }
+
+    return game->ball.circle.center;
+}
+
+static float millisecondsSinceAndReset(Uint64* counter)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    float milliseconds = nlrMillisecondsBetween(*counter, now);
+    *counter = now;
+    return milliseconds;
+}
+
+static void publishTelemetry(NlRender* self)
+{
+    const NlRenderStats* stats = &self->stats;
+    NlrTelemetryRecord record;
+
+    record.sequence = 0u;
+    record.frameIndex = 0u;
+    record.predictedTickId = stats->predictedTickId;
+    record.authoritativeTickId = stats->authoritativeTickId;
+    record.authoritativeStepsInBuffer = stats->authoritativeStepsInBuffer;
+    record.renderFps = stats->renderFps;
+    record.latencyMs = stats->latencyMs;
+    record.qualityTier = (int32_t) stats->qualityTier;
+    record.playoutDelayMs = stats->playoutDelayMs;
+    record.divergentAvatarCount = stats->divergentAvatarCount;
+    record.maxAvatarDivergence = stats->maxAvatarDivergence;
+    record.ballDivergence = stats->ballDivergence;
+    record.frameMs = stats->frameMs;
+    record.updateMs = stats->updateMs;
+    record.worldMs = stats->worldMs;
+    record.hudMs = stats->hudMs;
+    record.submitMs = stats->submitMs;
+    record.flags = stats->isIdle ? NLR_TELEMETRY_FLAG_IDLE : 0u;
+
+    nlrTelemetryPublish(&self->telemetry, &record);
+}
+
+typedef struct NlrFrameHash {
+    uint64_t value;
+} NlrFrameHash;
+
+static void frameHashInit(NlrFrameHash* self)
+{
+    self->value = 0xcbf29ce484222325u;
+}
+
+/// FNV-1a
+static void frameHashAdd(NlrFrameHash* self, const void* data, size_t octetCount)
+{
+    const uint8_t* octets = (const uint8_t*) data;
+    for (size_t i = 0u; i < octetCount; ++i) {
+        self->value ^= octets[i];
+        self->value *= 0x100000001b3u;
+    }
+}
+
+static void frameHashAddInt(NlrFrameHash* self, int value)
+{
+    frameHashAdd(self, &value, sizeof(value));
+}
+
+static void frameHashAddFloat(NlrFrameHash* self, float value)
+{
+    frameHashAdd(self, &value, sizeof(value));
+}
+
+static void frameHashAddVector2(NlrFrameHash* self, BlVector2 value)
+{
+    frameHashAddFloat(self, value.x);
+    frameHashAddFloat(self, value.y);
+}
+
+static void frameHashAddEntities(NlrFrameHash* hash, const NlGame* game)
+{
+    frameHashAddInt(hash, (int) game->avatars.avatarCount);
+    for (size_t i = 0u; i < game->avatars.avatarCount; ++i) {
+        const NlAvatar* avatar = &game->avatars.avatars[i];
+        frameHashAddVector2(hash, avatar->circle.center);
+        frameHashAddFloat(hash, avatar->visualRotation);
+        frameHashAddInt(hash, avatar->isInvisible);
+        frameHashAddInt(hash, avatar->teamIndex);
+    }
+    frameHashAddVector2(hash, game->ball.circle.center);
+}
+
+/// Everything that affects the rendered pixels, except the tick id itself, since ticks advance also when idle.
+/// Split by how a change should be redrawn.
+typedef struct NlrFrameHashes {
+    uint64_t scene;
+    uint64_t hud;
+    uint64_t stats;
+} NlrFrameHashes;
+
+static void calculateFrameHashes(NlrFrameHashes* hashes, const NlRender* self, const NlGame* authoritative,
+                                 const NlGame* main, const NlGame* alternative, const uint8_t localParticipants[],
+                                 size_t participantCount)
+{
+    NlrFrameHash hash;
+    frameHashInit(&hash);
+
+    int outputWidth = 0;
+    int outputHeight = 0;
+    SDL_GetRendererOutputSize(self->renderer, &outputWidth, &outputHeight);
+    frameHashAddInt(&hash, outputWidth);
+    frameHashAddInt(&hash, outputHeight);
+    frameHashAddVector2(&hash, self->camera.position);
+    frameHashAddFloat(&hash, self->camera.zoom);
+    frameHashAddInt(&hash, (int) self->mode);
+
+    frameHashAddEntities(&hash, main);
+    frameHashAddEntities(&hash, alternative);
+    for (size_t i = 0u; i < main->avatars.avatarCount; ++i) {
+        frameHashAddVector2(&hash, self->avatars[i].leadOffset);
+        frameHashAddFloat(&hash, self->avatars[i].rotationLead);
+    }
+    hashes->scene = hash.value;
+
+    frameHashInit(&hash);
+    frameHashAddInt(&hash, (int) self->quality.tier);
+
+    frameHashAddInt(&hash, (int) main->players.playerCount);
+    for (size_t i = 0u; i < main->players.playerCount; ++i) {
+        const NlPlayer* player = &main->players.players[i];
+        frameHashAddInt(&hash, (int) player->phase);
+        frameHashAddInt(&hash, player->preferredTeamId);
+        frameHashAddInt(&hash, player->controllingAvatarIndex);
+    }
+
+    frameHashAddInt(&hash, (int) main->phase);
+    frameHashAddInt(&hash, (int) main->phaseCountDown);
+    frameHashAddInt(&hash, (int) main->matchClockLeftInTicks);
+    frameHashAddInt(&hash, (int) authoritative->phase);
+    frameHashAddInt(&hash, (int) authoritative->latestScoredTeamIndex);
+    for (size_t i = 0u; i < authoritative->teams.teamCount; ++i) {
+        frameHashAddInt(&hash, authoritative->teams.teams[i].score);
+    }
+
+    frameHashAdd(&hash, localParticipants, participantCount);
+    for (size_t i = 0u; i < NLR_MAX_LOCAL_PLAYERS; ++i) {
+        const NlrLocalPlayer* localPlayer = &self->localPlayers[i];
+        if (!localPlayer->info.isUsed) {
+            continue;
+        }
+        frameHashAddInt(&hash, localPlayer->participantId);
+        frameHashAddInt(&hash, localPlayer->highlightedTeamIndex);
+        frameHashAddInt(&hash, localPlayer->selectedTeamIndex);
+    }
+    hashes->hud = hash.value;
+
+    // Tick ids and frame timings in the stats bar are only refreshed when a frame is drawn anyway
+    frameHashInit(&hash);
+    frameHashAddInt(&hash, self->stats.authoritativeStepsInBuffer);
+    frameHashAddInt(&hash, self->stats.renderFps);
+    frameHashAddInt(&hash, self->stats.latencyMs);
+    hashes->stats = hash.value;
+}
+
+/// The stats given to nlRenderUpdate() don't carry divergence, so it is copied from the last analysis every frame
+static void copyDivergenceStats(NlRender* self)
+{
+    self->stats.maxAvatarDivergence = self->divergence.maxAvatarError;
+    self->stats.ballDivergence = self->divergence.ballError;
+    self->stats.divergentAvatarCount = (int) self->divergence.divergentAvatarCount;
+}
+
+/// `isHudChanged` is set if the HUD or stats text differs from the last drawn frame, since it must then be rebuilt
+/// even if the quality tier only rebuilds it every few frames
+static bool isFrameChanged(NlRender* self, const NlrFrameHashes* hashes, bool* isHudChanged)
+{
+    // Let smoothing (e.g. avatar rotation and camera follow) come to rest before considering the scene idle
+    const uint32_t settleFrameCount = 60u;
+    // Latency and buffer depth change all the time in online play, they must not keep an idle screen awake
+    const float statsRefreshIntervalMs = 1000.0f;
+
+    bool isChanged = self->tickId != self->lastDrawnTickId && nlrAnimationsHasActive(&self->animations);
+
+    if (hashes->scene != self->lastSceneHash) {
+        self->lastSceneHash = hashes->scene;
+        self->settleFramesLeft = settleFrameCount;
+        isChanged = true;
+    } else if (self->settleFramesLeft > 0u) {
+        self->settleFramesLeft--;
+        isChanged = true;
+    }
+
+    // HUD changes are not smoothed, one frame is enough
+    *isHudChanged = hashes->hud != self->lastHudHash;
+    if (*isHudChanged) {
+        self->lastHudHash = hashes->hud;
+        isChanged = true;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (hashes->stats != self->lastStatsHash &&
+        nlrMillisecondsBetween(self->lastStatsRedrawCounter, now) >= statsRefreshIntervalMs) {
+        isChanged = true;
+    }
+
+    if (isChanged) {
+        // Any drawn frame shows the current stats
+        *isHudChanged = *isHudChanged || hashes->stats != self->lastStatsHash;
+        self->lastStatsHash = hashes->stats;
+        self->lastStatsRedrawCounter = now;
+    }
+
+    return isChanged;
+}
+
+/// Returns false if idle frames are skipped and nothing visible changed since the previous frame. The renderer is not
+/// touched at all in that case, and the caller should skip presenting, keeping the previously presented frame.
+bool nlRenderUpdate(NlRender* self, const NlGame* authoritative, const NlGame* predicted,
                     const uint8_t localParticipants[], size_t participantCount, NlRenderStats stats)
 {
+    Uint64 sectionStart = SDL_GetPerformanceCounter();
     self->stats = stats;
 
     const NlGame* mainGameStateToUse = predicted;
@@ -526,27 +1047,107 @@ void nlRenderUpdate(NlRender* self, const NlGame* authoritative, const NlGame* p
 
     spawnLocalPlayersIfNeeded(self, localParticipants, participantCount);
 
+    if (!self->isAuthoritativeFedExplicitly) {
+        // Fallback for callers that don't feed each step, arrivals are then only seen at render frame granularity.
+        // Relies on stats.authoritativeTickId advancing, otherwise the playout stays on the first fed state.
+        nlrPlayoutFeed(&self->playout, authoritative, stats.authoritativeTickId);
+    }
+
+    self->tickId = stats.predictedTickId;
     if (self->mode == NlRenderModeAuthoritative) {
-        mainGameStateToUse = authoritative;
+        const NlGame* playoutGameState = nlrPlayoutUpdate(&self->playout);
+        mainGameStateToUse = playoutGameState != 0 ? playoutGameState : authoritative;
         alternativeGameState = predicted;
+        self->tickId = playoutGameState != 0 ? (uint32_t) self->playout.playoutTickId : stats.authoritativeTickId;
+    }
+    self->stats.playoutDelayMs = (int) (nlrPlayoutDelayTicks(&self->playout) * (double) self->playout.tickDurationMs);
+
+    nlrAnimationsEvaluate(&self->animations, self->tickId);
+
+    if (self->mode != self->effectsMode) {
+        nlrEffectsClear(&self->effects, &self->animations);
+        self->effectsMode = self->mode;
     }
+    nlrEffectsRemoveFinished(&self->effects, &self->animations);
+    nlrEffectsObserveBall(&self->effects, &self->animations, &mainGameStateToUse->ball, self->tickId);
+    nlrEffectsObserveEntities(&self->effects, &self->animations, mainGameStateToUse, self->tickId, authoritative,
+                              stats.authoritativeTickId);
+
+    updateLocalAvatarLeads(self, mainGameStateToUse, stats.predictedTickId, localParticipants, participantCount);
+    nlrCameraUpdate(&self->camera, cameraFollowTarget(self, mainGameStateToUse, localParticipants, participantCount));
+
+    bool isIdle = false;
+    bool isHudChanged = false;
+    if (self->isSkippingIdleFrames) {
+        NlrFrameHashes frameHashes;
+        calculateFrameHashes(&frameHashes, self, authoritative, mainGameStateToUse, alternativeGameState,
+                             localParticipants, participantCount);
+        isIdle = !isFrameChanged(self, &frameHashes, &isHudChanged);
+    }
+    if (isIdle) {
+        // Nothing is drawn, so there is no render work to report to the quality governor
+        self->stats.isIdle = true;
+        self->stats.qualityTier = self->quality.tier;
+        self->stats.updateMs = millisecondsSinceAndReset(&sectionStart);
+        self->stats.frameMs = self->stats.updateMs;
+        self->stats.worldMs = 0.0f;
+        self->stats.hudMs = 0.0f;
+        self->stats.submitMs = 0.0f;
+        copyDivergenceStats(self);
+        publishTelemetry(self);
+        return false;
+    }
+    self->stats.isIdle = false;
+    self->lastDrawnTickId = self->tickId;
+
+    self->stats.qualityTier = self->quality.tier;
+    const uint32_t hudRefreshInterval = self->quality.tier >= NlrQualityTierReducedHud ? 4u : 1u;
+    // A changed HUD might only get this one drawn frame when idle frames are skipped, so it can't wait for its turn
+    bool isHudRefreshed = isHudChanged || (self->frameCount % hudRefreshInterval) == 0u;
+    self->frameCount++;
+    nlrTextBatchClear(&self->textBatch);
+
+    nlrViewportBegin(&self->viewport);
+
+    nlrDivergenceAnalyze(&self->divergence, mainGameStateToUse, alternativeGameState, self->shadowDivergenceThreshold);
+    copyDivergenceStats(self);
+
+    self->stats.updateMs = millisecondsSinceAndReset(&sectionStart);
 
-    // Render alternative first, since it isn't as important
-    renderAvatars(self, self->shadowAvatars, &alternativeGameState->avatars, alternativeAlpha);
-    renderBall(self, &self->shadowBall, &alternativeGameState->ball, alternativeAlpha);
+    // Render alternative first, since it isn't as important. Only where it differs noticeably from the main state
+    renderShadowAvatars(self, &alternativeGameState->avatars, alternativeAlpha);
+    renderShadowBall(self, &alternativeGameState->ball, alternativeAlpha);
 
     // ------------------------------
 
     renderPlayers(self, &mainGameStateToUse->players);
     renderAvatars(self, self->avatars, &mainGameStateToUse->avatars, mainAlpha);
     renderBalls(self, mainGameStateToUse, mainAlpha);
+    renderEffects(self);
 
-    renderGoals(&self->rectangleRender, &g_nlConstants);
-    renderBorders(&self->rectangleRender, &g_nlConstants);
-    renderHud(&self->font, &self->bigFont, authoritative, mainGameStateToUse);
+    renderGoals(&self->rectangleRender, &self->camera, &g_nlConstants);
+    renderBorders(&self->rectangleRender, &self->camera, &g_nlConstants);
+    self->stats.worldMs = millisecondsSinceAndReset(&sectionStart);
+
+    renderStatsBackground(self);
+    if (isHudRefreshed) {
+        nlrTextBatchClear(&self->hudTextBatch);
+        renderHud(&self->hudFont, &self->hudBigFont, authoritative, mainGameStateToUse);
+        renderStats(self);
+    }
     renderForLocalParticipants(self, mainGameStateToUse, localParticipants, participantCount);
+    self->stats.hudMs = millisecondsSinceAndReset(&sectionStart);
+
+    nlrFontAtlasRender(&self->fontAtlas, &self->hudTextBatch);
+    nlrFontAtlasRender(&self->fontAtlas, &self->textBatch);
+    nlrViewportPresent(&self->viewport);
+    self->stats.submitMs = millisecondsSinceAndReset(&sectionStart);
+    self->stats.frameMs = self->stats.updateMs + self->stats.worldMs + self->stats.hudMs + self->stats.submitMs;
+    nlrQualityGovernorUpdate(&self->quality, self->stats.frameMs);
+
+    publishTelemetry(self);
 
-    renderStats(self);
+    return true;
 }
 
 static void teamSelection(NlrLocalPlayer* renderLocalPlayer, int horizontal)
@@ -595,7 +1196,31 @@ void nlRenderFeedInput(NlRender* self, SrGamepad* gamepads, const NlGame* predic
     }
 }
 
+/// Optional. Call for every authoritative step as it is received from the network, including several in one burst,
+/// so the playout buffer holds all of them and measures arrival jitter at the network arrival time.
+/// nlRenderUpdate() stops sampling the authoritative state it is given once this has been called.
+void nlRenderFeedAuthoritative(NlRender* self, const NlGame* authoritative, uint32_t tickId)
+{
+    self->isAuthoritativeFedExplicitly = true;
+    nlrPlayoutFeed(&self->playout, authoritative, tickId);
+}
+
+/// Optional. The render work per frame (everything in nlRenderUpdate, not counting vsync or the caller's present)
+/// that the quality governor tries to stay within. Defaults to half of a 60 Hz frame.
+void nlRenderSetWorkBudget(NlRender* self, float workBudgetMs)
+{
+    nlrQualityGovernorSetBudget(&self->quality, workBudgetMs);
+}
+
+/// Optional. Publishes NlRenderStats for every frame to a shared memory ring that external tools can read.
+int nlRenderTelemetryInit(NlRender* self, const char* sharedMemoryName)
+{
+    return nlrTelemetryInit(&self->telemetry, sharedMemoryName);
+}
+
 void nlRenderClose(NlRender* self)
 {
-    (void) self;
+    nlrTelemetryClose(&self->telemetry);
+    nlrFontAtlasClose(&self->fontAtlas);
+    nlrViewportClose(&self->viewport);
 }
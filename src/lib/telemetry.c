@@ -0,0 +1,106 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <clog/clog.h>
+#include <nimble-ball-presentation/telemetry.h>
+#include <string.h>
+
+#if defined TORNADO_OS_LINUX || defined TORNADO_OS_MACOS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// Creates (or reuses) the shared memory ring. All system calls and mapping are done here, never when publishing.
+int nlrTelemetryInit(NlrTelemetry* self, const char* sharedMemoryName)
+{
+    self->ring = 0;
+    self->frameIndex = 0u;
+
+    int fd = shm_open(sharedMemoryName, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        CLOG_WARN("telemetry: could not open shared memory '%s'", sharedMemoryName)
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t) sizeof(NlrTelemetryRing)) < 0) {
+        CLOG_WARN("telemetry: could not resize shared memory '%s'", sharedMemoryName)
+        close(fd);
+        return -2;
+    }
+
+    void* mapped = mmap(0, sizeof(NlrTelemetryRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        CLOG_WARN("telemetry: could not map shared memory '%s'", sharedMemoryName)
+        return -3;
+    }
+
+    NlrTelemetryRing* ring = (NlrTelemetryRing*) mapped;
+    memset(ring, 0, sizeof(NlrTelemetryRing));
+    ring->capacity = NLR_TELEMETRY_RECORD_CAPACITY;
+    ring->recordSize = sizeof(NlrTelemetryRecord);
+    ring->version = NLR_TELEMETRY_VERSION;
+    // Magic is written last, readers ignore the ring until it is set
+    __atomic_store_n(&ring->magic, NLR_TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+
+    self->ring = ring;
+
+    return 0;
+}
+
+/// Never blocks or allocates. Readers detect torn records through the sequence number.
+void nlrTelemetryPublish(NlrTelemetry* self, const NlrTelemetryRecord* record)
+{
+    NlrTelemetryRing* ring = self->ring;
+    if (ring == 0) {
+        return;
+    }
+
+    uint64_t frameIndex = self->frameIndex++;
+    NlrTelemetryRecord* target = &ring->records[frameIndex % NLR_TELEMETRY_RECORD_CAPACITY];
+
+    __atomic_store_n(&target->sequence, frameIndex * 2u + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy((uint8_t*) target + sizeof(target->sequence), (const uint8_t*) record + sizeof(record->sequence),
+           sizeof(NlrTelemetryRecord) - sizeof(record->sequence));
+    target->frameIndex = frameIndex;
+
+    __atomic_store_n(&target->sequence, frameIndex * 2u + 2u, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->writeIndex, frameIndex + 1u, __ATOMIC_RELEASE);
+}
+
+void nlrTelemetryClose(NlrTelemetry* self)
+{
+    if (self->ring == 0) {
+        return;
+    }
+
+    munmap(self->ring, sizeof(NlrTelemetryRing));
+    self->ring = 0;
+}
+
+#else
+
+int nlrTelemetryInit(NlrTelemetry* self, const char* sharedMemoryName)
+{
+    (void) sharedMemoryName;
+    self->ring = 0;
+    self->frameIndex = 0u;
+    CLOG_WARN("telemetry: shared memory is not supported on this platform")
+    return -1;
+}
+
+void nlrTelemetryPublish(NlrTelemetry* self, const NlrTelemetryRecord* record)
+{
+    (void) self;
+    (void) record;
+}
+
+void nlrTelemetryClose(NlrTelemetry* self)
+{
+    (void) self;
+}
+
+#endif
@@ -0,0 +1,245 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Peter Bjorklund. All rights reserved.
+ *  Licensed under the MIT License. See LICENSE in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <nimble-ball-presentation/telemetry.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef enum OutputFormat {
+    OutputFormatCsv,
+    OutputFormatJson,
+} OutputFormat;
+
+typedef struct Summary {
+    uint64_t recordCount;
+    float minFrameMs;
+    float maxFrameMs;
+    double totalFrameMs;
+    double totalFps;
+    double totalLatencyMs;
+    float maxAvatarDivergence;
+    float maxBallDivergence;
+    int32_t worstQualityTier;
+    uint64_t idleRecordCount;
+} Summary;
+
+static void summaryInit(Summary* self)
+{
+    memset(self, 0, sizeof(*self));
+}
+
+static void summaryAdd(Summary* self, const NlrTelemetryRecord* record)
+{
+    // Idle frames are not drawn, so they would only skew the frame timings
+    if ((record->flags & NLR_TELEMETRY_FLAG_IDLE) != 0u) {
+        self->idleRecordCount++;
+        return;
+    }
+    if (self->recordCount == 0u || record->frameMs < self->minFrameMs) {
+        self->minFrameMs = record->frameMs;
+    }
+    if (record->frameMs > self->maxFrameMs) {
+        self->maxFrameMs = record->frameMs;
+    }
+    if (record->maxAvatarDivergence > self->maxAvatarDivergence) {
+        self->maxAvatarDivergence = record->maxAvatarDivergence;
+    }
+    if (record->ballDivergence > self->maxBallDivergence) {
+        self->maxBallDivergence = record->ballDivergence;
+    }
+    if (record->qualityTier > self->worstQualityTier) {
+        self->worstQualityTier = record->qualityTier;
+    }
+    self->totalFrameMs += (double) record->frameMs;
+    self->totalFps += (double) record->renderFps;
+    self->totalLatencyMs += (double) record->latencyMs;
+    self->recordCount++;
+}
+
+/// Copies a record out of the ring. Returns 0 if the record was overwritten or is being written.
+static int readRecord(const NlrTelemetryRing* ring, uint64_t frameIndex, NlrTelemetryRecord* out)
+{
+    const NlrTelemetryRecord* source = &ring->records[frameIndex % NLR_TELEMETRY_RECORD_CAPACITY];
+    uint64_t expectedSequence = frameIndex * 2u + 2u;
+
+    uint64_t before = __atomic_load_n(&source->sequence, __ATOMIC_ACQUIRE);
+    if (before != expectedSequence) {
+        return 0;
+    }
+    memcpy(out, (const void*) source, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t after = __atomic_load_n(&source->sequence, __ATOMIC_RELAXED);
+
+    return after == expectedSequence;
+}
+
+static void printCsvHeader(void)
+{
+    printf("frameIndex,predictedTickId,authoritativeTickId,authoritativeStepsInBuffer,renderFps,latencyMs,"
+           "qualityTier,playoutDelayMs,divergentAvatarCount,maxAvatarDivergence,ballDivergence,frameMs,updateMs,"
+           "worldMs,hudMs,submitMs,isIdle\n");
+}
+
+static void printCsvRecord(const NlrTelemetryRecord* record)
+{
+    printf("%llu,%u,%u,%d,%d,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
+           (unsigned long long) record->frameIndex, record->predictedTickId, record->authoritativeTickId,
+           record->authoritativeStepsInBuffer, record->renderFps, record->latencyMs, record->qualityTier,
+           record->playoutDelayMs, record->divergentAvatarCount, (double) record->maxAvatarDivergence,
+           (double) record->ballDivergence, (double) record->frameMs, (double) record->updateMs,
+           (double) record->worldMs, (double) record->hudMs, (double) record->submitMs,
+           (record->flags & NLR_TELEMETRY_FLAG_IDLE) != 0u);
+}
+
+static void printJsonRecord(const NlrTelemetryRecord* record, int isFirst)
+{
+    printf("%s\n    {\"frameIndex\": %llu, \"predictedTickId\": %u, \"authoritativeTickId\": %u, "
+           "\"authoritativeStepsInBuffer\": %d, \"renderFps\": %d, \"latencyMs\": %d, \"qualityTier\": %d, "
+           "\"playoutDelayMs\": %d, \"divergentAvatarCount\": %d, \"maxAvatarDivergence\": %.3f, "
+           "\"ballDivergence\": %.3f, \"frameMs\": %.3f, \"updateMs\": %.3f, \"worldMs\": %.3f, \"hudMs\": %.3f, "
+           "\"submitMs\": %.3f, \"isIdle\": %s}",
+           isFirst ? "" : ",", (unsigned long long) record->frameIndex, record->predictedTickId,
+           record->authoritativeTickId, record->authoritativeStepsInBuffer, record->renderFps, record->latencyMs,
+           record->qualityTier, record->playoutDelayMs, record->divergentAvatarCount,
+           (double) record->maxAvatarDivergence, (double) record->ballDivergence, (double) record->frameMs,
+           (double) record->updateMs, (double) record->worldMs, (double) record->hudMs, (double) record->submitMs,
+           (record->flags & NLR_TELEMETRY_FLAG_IDLE) != 0u ? "true" : "false");
+}
+
+static void printJsonSummary(const Summary* summary)
+{
+    double count = summary->recordCount > 0u ? (double) summary->recordCount : 1.0;
+    printf("  \"summary\": {\"recordCount\": %llu, \"minFrameMs\": %.3f, \"averageFrameMs\": %.3f, "
+           "\"maxFrameMs\": %.3f, \"averageFps\": %.1f, \"averageLatencyMs\": %.1f, \"maxAvatarDivergence\": %.3f, "
+           "\"maxBallDivergence\": %.3f, \"worstQualityTier\": %d, \"idleRecordCount\": %llu}",
+           (unsigned long long) summary->recordCount, (double) summary->minFrameMs, summary->totalFrameMs / count,
+           (double) summary->maxFrameMs, summary->totalFps / count, summary->totalLatencyMs / count,
+           (double) summary->maxAvatarDivergence, (double) summary->maxBallDivergence, summary->worstQualityTier,
+           (unsigned long long) summary->idleRecordCount);
+}
+
+static uint64_t oldestAvailable(uint64_t writeIndex)
+{
+    return writeIndex > NLR_TELEMETRY_RECORD_CAPACITY ? writeIndex - NLR_TELEMETRY_RECORD_CAPACITY : 0u;
+}
+
+static void dump(const NlrTelemetryRing* ring, OutputFormat format)
+{
+    uint64_t writeIndex = __atomic_load_n(&ring->writeIndex, __ATOMIC_ACQUIRE);
+    Summary summary;
+    summaryInit(&summary);
+
+    if (format == OutputFormatCsv) {
+        printCsvHeader();
+    } else {
+        printf("{\n  \"records\": [");
+    }
+
+    int isFirstPrinted = 1;
+    for (uint64_t i = oldestAvailable(writeIndex); i < writeIndex; ++i) {
+        NlrTelemetryRecord record;
+        if (!readRecord(ring, i, &record)) {
+            continue;
+        }
+        if (format == OutputFormatCsv) {
+            printCsvRecord(&record);
+        } else {
+            // Not the summary count, since that skips idle records
+            printJsonRecord(&record, isFirstPrinted);
+            isFirstPrinted = 0;
+        }
+        summaryAdd(&summary, &record);
+    }
+
+    if (format == OutputFormatJson) {
+        printf("\n  ],\n");
+        printJsonSummary(&summary);
+        printf("\n}\n");
+    }
+}
+
+static void follow(const NlrTelemetryRing* ring)
+{
+    const struct timespec pollInterval = {0, 100 * 1000 * 1000};
+    uint64_t readIndex = __atomic_load_n(&ring->writeIndex, __ATOMIC_ACQUIRE);
+
+    printCsvHeader();
+    while (1) {
+        uint64_t writeIndex = __atomic_load_n(&ring->writeIndex, __ATOMIC_ACQUIRE);
+        if (readIndex < oldestAvailable(writeIndex)) {
+            readIndex = oldestAvailable(writeIndex);
+        }
+        for (; readIndex < writeIndex; ++readIndex) {
+            NlrTelemetryRecord record;
+            if (readRecord(ring, readIndex, &record)) {
+                printCsvRecord(&record);
+            }
+        }
+        fflush(stdout);
+        nanosleep(&pollInterval, 0);
+    }
+}
+
+static void printUsage(const char* name)
+{
+    fprintf(stderr, "usage: %s [--csv | --json | --follow] [shared memory name, default %s]\n", name,
+            NLR_TELEMETRY_DEFAULT_NAME);
+}
+
+int main(int argc, char* argv[])
+{
+    OutputFormat format = OutputFormatCsv;
+    int isFollowing = 0;
+    const char* sharedMemoryName = NLR_TELEMETRY_DEFAULT_NAME;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            format = OutputFormatCsv;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            format = OutputFormatJson;
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            isFollowing = 1;
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            sharedMemoryName = argv[i];
+        }
+    }
+
+    int fd = shm_open(sharedMemoryName, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "could not open shared memory '%s'\n", sharedMemoryName);
+        return 2;
+    }
+
+    void* mapped = mmap(0, sizeof(NlrTelemetryRing), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "could not map shared memory '%s'\n", sharedMemoryName);
+        return 3;
+    }
+
+    const NlrTelemetryRing* ring = (const NlrTelemetryRing*) mapped;
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != NLR_TELEMETRY_MAGIC ||
+        ring->version != NLR_TELEMETRY_VERSION || ring->recordSize != sizeof(NlrTelemetryRecord)) {
+        fprintf(stderr, "'%s' is not a compatible telemetry ring\n", sharedMemoryName);
+        munmap(mapped, sizeof(NlrTelemetryRing));
+        return 4;
+    }
+
+    if (isFollowing) {
+        follow(ring);
+    } else {
+        dump(ring, format);
+    }
+
+    munmap(mapped, sizeof(NlrTelemetryRing));
+
+    return 0;
+}